@@ -1,9 +1,12 @@
 #include <Wio3GforArduino.h>
+#include <Wio3GUdpSession.h>
 
 #define INTERVAL        (60000)
 #define RECEIVE_TIMEOUT (10000)
 
 Wio3G Wio;
+Wio3GUdpSession Session(&Wio);
+bool Received;
   
 void setup() {
   delay(200);
@@ -31,52 +34,48 @@ void setup() {
     return;
   }
 
+  SerialUSB.println("### Open.");
+  Session.SetReceiveCallback(OnReceive, NULL);
+  if (!Session.Begin("funnel.soracom.io", 23080)) {
+    SerialUSB.println("### ERROR! ###");   // Session.Poll() retries the open.
+  }
+
   SerialUSB.println("### Setup completed.");
 }
 
 void loop() {
   char data[100];
   
-  SerialUSB.println("### Open.");
-  int connectId;
-  connectId = Wio.SocketOpen("funnel.soracom.io", 23080, WIO_UDP);
-  if (connectId < 0) {
-    SerialUSB.println("### ERROR! ###");
-    goto err;
-  }
-
   SerialUSB.println("### Send.");
   sprintf(data, "{\"uptime\":%lu}", millis() / 1000);
   SerialUSB.print("Send:");
   SerialUSB.print(data);
   SerialUSB.println("");
-  if (!Wio.SocketSend(connectId, data)) {
+  if (!Session.Send(data)) {
     SerialUSB.println("### ERROR! ###");
-    goto err_close;
+    goto err;
   }
   
   SerialUSB.println("### Receive.");
-  int length;
-  length = Wio.SocketReceive(connectId, data, sizeof (data), RECEIVE_TIMEOUT);
-  if (length < 0) {
-    SerialUSB.println("### ERROR! ###");
-    goto err_close;
+  Received = false;
+  unsigned long start;
+  start = millis();
+  while (!Received && millis() - start < RECEIVE_TIMEOUT) {
+    Session.Poll();
   }
-  if (length == 0) {
+  if (!Received) {
     SerialUSB.println("### RECEIVE TIMEOUT! ###");
-    goto err_close;
-  }
-  SerialUSB.print("Receive:");
-  SerialUSB.print(data);
-  SerialUSB.println("");
-
-err_close:
-  SerialUSB.println("### Close.");
-  if (!Wio.SocketClose(connectId)) {
-    SerialUSB.println("### ERROR! ###");
     goto err;
   }
   
 err:
   delay(INTERVAL);
 }
+
+void OnReceive(const byte* data, int dataSize, void* context)
+{
+  SerialUSB.print("Receive:");
+  SerialUSB.write(data, dataSize);
+  SerialUSB.println("");
+  Received = true;
+}
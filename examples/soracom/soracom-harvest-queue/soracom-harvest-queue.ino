@@ -0,0 +1,107 @@
+#include <Wio3GforArduino.h>
+#include <Wio3GRecordQueue.h>
+
+#define SAMPLE_INTERVAL (10000)
+#define SEND_INTERVAL   (60000)
+#define RECORD_SIZE     (40)
+#define BATCH_NUM       (6)
+
+Wio3G Wio;
+Wio3GRecordQueue Queue;
+bool Activated;
+unsigned long LastSample;
+unsigned long LastSend;
+
+void setup() {
+  delay(200);
+
+  SerialUSB.begin(115200);
+  SerialUSB.println("");
+  SerialUSB.println("--- START ---------------------------------------------------");
+
+  // The records are kept in the backup SRAM, so the ones not sent yet survive a reset.
+  SerialUSB.println("### Queue Initialize.");
+  int storageSize;
+  void* storage = Wio3GRecordQueue::BackupSramBegin(&storageSize);
+  if (!Queue.Begin(storage, storageSize, RECORD_SIZE, Wio3GRecordQueue::DROP_OLDEST)) {
+    SerialUSB.println("### ERROR! ###");
+    return;
+  }
+  SerialUSB.print(Queue.Size());
+  SerialUSB.println(" record(s) left from before the reset.");
+
+  SerialUSB.println("### I/O Initialize.");
+  Wio.Init();
+
+  SerialUSB.println("### Power supply ON.");
+  Wio.PowerSupplyCellular(true);
+  delay(500);
+
+  SerialUSB.println("### Turn on or reset.");
+  if (!Wio.TurnOnOrReset()) {
+    SerialUSB.println("### ERROR! ###");
+    return;
+  }
+
+  SerialUSB.println("### Setup completed.");
+}
+
+void loop() {
+  if (millis() - LastSample >= SAMPLE_INTERVAL) {
+    LastSample = millis();
+
+    char data[RECORD_SIZE];
+    int dataSize = sprintf(data, "{\"uptime\":%lu}", millis() / 1000);
+    Queue.Push((const byte*)data, dataSize);   // Overwrites the oldest record when full.
+  }
+
+  if (millis() - LastSend >= SEND_INTERVAL && !Queue.IsEmpty()) {
+    LastSend = millis();
+    Send();
+  }
+}
+
+// Open a socket and send the queued records in batches of BATCH_NUM.
+// A batch is popped only after it was sent, so what fails stays queued for the next time.
+void Send()
+{
+  if (!Activated) {
+    SerialUSB.println("### Connecting to \"soracom.io\".");
+    if (!Wio.Activate("soracom.io", "sora", "sora")) {
+      SerialUSB.println("### ERROR! ###");
+      return;
+    }
+    Activated = true;
+  }
+
+  SerialUSB.println("### Open.");
+  int connectId = Wio.SocketOpen("harvest.soracom.io", 8514, WIO_UDP);
+  if (connectId < 0) {
+    SerialUSB.println("### ERROR! ###");
+    Activated = false;
+    return;
+  }
+
+  SerialUSB.println("### Send.");
+  while (!Queue.IsEmpty()) {
+    int sent = 0;
+    for (; sent < BATCH_NUM && sent < Queue.Size(); sent++) {
+      int dataSize;
+      const byte* data = Queue.Peek(sent, &dataSize);
+      if (!Wio.SocketSend(connectId, data, dataSize)) break;
+    }
+    if (sent <= 0) {
+      SerialUSB.println("### ERROR! ###");
+      break;
+    }
+    Queue.Pop(sent);
+    SerialUSB.print("Sent ");
+    SerialUSB.print(sent);
+    SerialUSB.print(", ");
+    SerialUSB.print(Queue.Size());
+    SerialUSB.println(" left.");
+  }
+
+  SerialUSB.println("### Close.");
+  Wio.SocketClose(connectId);
+}
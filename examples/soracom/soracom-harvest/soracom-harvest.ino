@@ -1,4 +1,5 @@
 #include <Wio3GforArduino.h>
+#include <Wio3GUdpSession.h>
 
 #define INTERVAL        (60000)
 #define RECEIVE_TIMEOUT (10000)
@@ -7,6 +8,8 @@
 // #define SENSOR_PIN    (WIO_D38)
 
 Wio3G Wio;
+Wio3GUdpSession Session(&Wio);
+bool Received;
 
 void setup() {
   delay(200);
@@ -38,6 +41,12 @@ void setup() {
   TemperatureAndHumidityBegin(SENSOR_PIN);
 #endif // SENSOR_PIN
 
+  SerialUSB.println("### Open.");
+  Session.SetReceiveCallback(OnReceive, NULL);
+  if (!Session.Begin("harvest.soracom.io", 8514)) {
+    SerialUSB.println("### ERROR! ###");   // Session.Poll() retries the open.
+  }
+
   SerialUSB.println("### Setup completed.");
 }
 
@@ -65,42 +74,24 @@ void loop() {
   sprintf(data, "{\"uptime\":%lu}", millis() / 1000);
 #endif // SENSOR_PIN
 
-  SerialUSB.println("### Open.");
-  int connectId;
-  connectId = Wio.SocketOpen("harvest.soracom.io", 8514, WIO_UDP);
-  if (connectId < 0) {
-    SerialUSB.println("### ERROR! ###");
-    goto err;
-  }
-
   SerialUSB.println("### Send.");
   SerialUSB.print("Send:");
   SerialUSB.print(data);
   SerialUSB.println("");
-  if (!Wio.SocketSend(connectId, data)) {
+  if (!Session.Send(data)) {
     SerialUSB.println("### ERROR! ###");
-    goto err_close;
+    goto err;
   }
 
   SerialUSB.println("### Receive.");
-  int length;
-  length = Wio.SocketReceive(connectId, data, sizeof (data), RECEIVE_TIMEOUT);
-  if (length < 0) {
-    SerialUSB.println("### ERROR! ###");
-    goto err_close;
+  Received = false;
+  unsigned long start;
+  start = millis();
+  while (!Received && millis() - start < RECEIVE_TIMEOUT) {
+    Session.Poll();
   }
-  if (length == 0) {
+  if (!Received) {
     SerialUSB.println("### RECEIVE TIMEOUT! ###");
-    goto err_close;
-  }
-  SerialUSB.print("Receive:");
-  SerialUSB.print(data);
-  SerialUSB.println("");
-
-err_close:
-  SerialUSB.println("### Close.");
-  if (!Wio.SocketClose(connectId)) {
-    SerialUSB.println("### ERROR! ###");
     goto err;
   }
 
@@ -108,6 +99,14 @@ err:
   delay(INTERVAL);
 }
 
+void OnReceive(const byte* data, int dataSize, void* context)
+{
+  SerialUSB.print("Receive:");
+  SerialUSB.write(data, dataSize);
+  SerialUSB.println("");
+  Received = true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////
 //
 
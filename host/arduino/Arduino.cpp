@@ -0,0 +1,187 @@
+#include <Arduino.h>
+#include "HostArduino.h"
+
+#define PIN_NUM		(5 * 16)
+
+static uint64_t Nanos = 0;
+static uint8_t PinValues[PIN_NUM];
+static HostArduino::PinWriteHook PinWrite = NULL;
+static HostArduino::PinReadHook PinRead = NULL;
+static void* PinContext = NULL;
+
+uint64_t HostArduino::GetNanos()
+{
+	return Nanos;
+}
+
+void HostArduino::AdvanceNanos(uint64_t nanos)
+{
+	Nanos += nanos;
+}
+
+void HostArduino::AdvanceTo(uint64_t nanos)
+{
+	if (nanos > Nanos) Nanos = nanos;
+}
+
+void HostArduino::SetPinHooks(PinWriteHook writeHook, PinReadHook readHook, void* context)
+{
+	PinWrite = writeHook;
+	PinRead = readHook;
+	PinContext = context;
+}
+
+int HostArduino::GetPin(uint32_t pin)
+{
+	return pin < PIN_NUM ? PinValues[pin] : LOW;
+}
+
+unsigned long millis()
+{
+	return (unsigned long)(Nanos / 1000000);
+}
+
+unsigned long micros()
+{
+	return (unsigned long)(Nanos / 1000);
+}
+
+void delay(unsigned long ms)
+{
+	Nanos += (uint64_t)ms * 1000000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	Nanos += (uint64_t)us * 1000;
+}
+
+void pinMode(uint32_t pin, uint32_t mode)
+{
+	if (pin < PIN_NUM && mode == INPUT_PULLUP) PinValues[pin] = HIGH;
+}
+
+void digitalWrite(uint32_t pin, uint32_t value)
+{
+	if (pin < PIN_NUM) PinValues[pin] = value ? HIGH : LOW;
+	if (PinWrite != NULL) PinWrite(pin, value ? HIGH : LOW, PinContext);
+}
+
+int digitalRead(uint32_t pin)
+{
+	if (PinRead != NULL) {
+		int value = PinRead(pin, PinContext);
+		if (value >= 0) return value;
+	}
+
+	return HostArduino::GetPin(pin);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Print
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+	for (size_t i = 0; i < size; i++) write(buffer[i]);
+
+	return size;
+}
+
+size_t Print::print(const char* str)
+{
+	return write((const uint8_t*)str, strlen(str));
+}
+
+size_t Print::print(char value)
+{
+	return write((uint8_t)value);
+}
+
+size_t Print::print(int value)
+{
+	return print((long)value);
+}
+
+size_t Print::print(unsigned int value)
+{
+	return print((unsigned long)value);
+}
+
+size_t Print::print(long value)
+{
+	char str[24];
+	sprintf(str, "%ld", value);
+	return print(str);
+}
+
+size_t Print::print(unsigned long value)
+{
+	char str[24];
+	sprintf(str, "%lu", value);
+	return print(str);
+}
+
+size_t Print::println()
+{
+	return print("\r\n");
+}
+
+size_t Print::println(const char* str)
+{
+	return print(str) + println();
+}
+
+size_t Print::println(int value)
+{
+	return print(value) + println();
+}
+
+size_t Print::println(unsigned long value)
+{
+	return print(value) + println();
+}
+
+size_t Stream::readBytes(char* buffer, size_t length)
+{
+	size_t count = 0;
+	while (count < length) {
+		int c = read();
+		if (c < 0) break;
+		buffer[count++] = (char)c;
+	}
+
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// String, IPAddress
+
+String::String(const char* str)
+{
+	snprintf(_Buffer, sizeof (_Buffer), "%s", str);
+}
+
+String::String(int value)
+{
+	snprintf(_Buffer, sizeof (_Buffer), "%d", value);
+}
+
+String& String::operator+=(const char* str)
+{
+	int length = strlen(_Buffer);
+	snprintf(&_Buffer[length], sizeof (_Buffer) - length, "%s", str);
+	return *this;
+}
+
+String& String::operator+=(const String& str)
+{
+	return *this += str.c_str();
+}
+
+IPAddress::IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	_Address[0] = a;
+	_Address[1] = b;
+	_Address[2] = c;
+	_Address[3] = d;
+}
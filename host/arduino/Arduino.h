@@ -0,0 +1,87 @@
+#pragma once
+
+// The part of the Arduino core the library uses, for building it on a Linux host.
+// Time is virtual. It only moves on delay() and when the simulated module is waited for. See HostArduino.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef uint8_t byte;
+
+#define HIGH			(0x1)
+#define LOW				(0x0)
+#define INPUT			(0x0)
+#define OUTPUT			(0x1)
+#define INPUT_PULLUP	(0x2)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t data) = 0;
+	virtual size_t write(const uint8_t* buffer, size_t size);
+
+	size_t print(const char* str);
+	size_t print(char value);
+	size_t print(int value);
+	size_t print(unsigned int value);
+	size_t print(long value);
+	size_t print(unsigned long value);
+	size_t println();
+	size_t println(const char* str);
+	size_t println(int value);
+	size_t println(unsigned long value);
+
+};
+
+class Stream : public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	virtual void flush() = 0;
+	size_t readBytes(char* buffer, size_t length);
+
+};
+
+class String
+{
+private:
+	char _Buffer[64];
+
+public:
+	String(const char* str = "");
+	String(int value);
+	String& operator+=(const char* str);
+	String& operator+=(const String& str);
+	const char* c_str() const { return _Buffer; }
+
+};
+
+class IPAddress
+{
+private:
+	uint8_t _Address[4];
+
+public:
+	IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0);
+	uint8_t operator[](int index) const { return _Address[index]; }
+
+};
+
+// Board objects are defined by the core and Wio3GHardware.cpp, which are not built on the host.
+class HardwareSerial;
+class TwoWire;
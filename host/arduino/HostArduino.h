@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Control of the host Arduino core: the virtual clock and the pins.
+class HostArduino
+{
+public:
+	typedef void (*PinWriteHook)(uint32_t pin, uint32_t value, void* context);
+	typedef int (*PinReadHook)(uint32_t pin, void* context);
+
+	static uint64_t GetNanos();
+	static void AdvanceNanos(uint64_t nanos);
+	static void AdvanceTo(uint64_t nanos);
+
+	// One hook at a time; the module simulator installs itself. readHook returns -1 for pins it does not drive.
+	static void SetPinHooks(PinWriteHook writeHook, PinReadHook readHook, void* context);
+	static int GetPin(uint32_t pin);
+
+};
@@ -0,0 +1,11 @@
+#include "Internal/Wio3GSK6812.h"
+
+// The LED is driven by bit-banging GPIOB on the board. Nothing to drive on the host.
+
+void Wio3GSK6812::Reset()
+{
+}
+
+void Wio3GSK6812::SetSingleLED(uint8_t r, uint8_t g, uint8_t b)
+{
+}
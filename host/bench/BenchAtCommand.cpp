@@ -0,0 +1,33 @@
+// Round trip of one AT command (AT+CSQ) at each UART rate: virtual time on the simulated link, and host cycles per command (simulator included).
+
+#include "HostTest.h"
+#include <stdio.h>
+
+#define COMMAND_NUM	(1000)
+
+int main()
+{
+	static const long baudRates[] = { 115200, 230400, 460800, 921600 };
+
+	for (unsigned i = 0; i < sizeof (baudRates) / sizeof (baudRates[0]); i++) {
+		ModemSimulator sim;
+		Wio3G wio(sim.GetSerial());
+		CHECK(wio.SetBaudRate(baudRates[i]));
+		CHECK(HostTest::BringUp(&wio));
+		CHECK(wio.GetBaudRate() == baudRates[i]);
+
+		unsigned long beginTime = micros();
+		uint64_t beginCycles = HostTest::Cycles();
+		for (int j = 0; j < COMMAND_NUM; j++) CHECK(wio.GetReceivedSignalStrength() == -73);
+		uint64_t cycles = HostTest::Cycles() - beginCycles;
+		unsigned long elapsed = micros() - beginTime;
+
+		char name[40];
+		sprintf(name, "csq_round_trip_%ld", baudRates[i]);
+		HostTest::Report(name, (double)elapsed / COMMAND_NUM, "us");
+		sprintf(name, "csq_host_cycles_%ld", baudRates[i]);
+		HostTest::Report(name, (double)cycles / COMMAND_NUM, "cycles");
+	}
+
+	return HostTest::Result();
+}
@@ -0,0 +1,92 @@
+// Host cycles per KB of a 1460-byte QISEND payload and a 1500-byte QIRD payload through AtSerial:
+// the baseline byte loops (a virtual Write/Read per byte, and a Stopwatch restart and WaitForAvailable per byte read)
+// against the bulk WriteBinary/ReadBinary. The serial port is MemorySerial, which copies the written bytes the same way for both, so only the driver side differs.
+
+#include "HostTest.h"
+#include "MemorySerial.h"
+#include "Internal/AtSerial.h"
+#include "Internal/Stopwatch.h"
+#include <stdio.h>
+
+#define WRITE_SIZE	(1460)
+#define READ_SIZE	(1500)
+#define REPEAT_NUM	(20000)
+
+// Baseline AtSerial::WriteBinary.
+__attribute__((noinline)) static void WriteBinaryBaseline(SerialAPI* serial, const byte* data, int dataSize)
+{
+	for (int i = 0; i < dataSize; i++) {
+		serial->Write(data[i]);
+	}
+}
+
+// Baseline AtSerial::ReadBinary with its WaitForAvailable.
+__attribute__((noinline)) static bool ReadBinaryBaseline(SerialAPI* serial, byte* data, int dataSize, unsigned long timeout)
+{
+	Stopwatch sw;
+	for (int i = 0; i < dataSize; i++) {
+		sw.Restart();
+		while (!serial->Available()) {
+			if (sw.ElapsedMilliseconds() >= timeout) return false;
+		}
+
+		data[i] = serial->Read();
+	}
+
+	return true;
+}
+
+static void Report(const char* name, uint64_t cycles, unsigned long bytes)
+{
+	HostTest::Report(name, (double)cycles * 1024 / bytes, "cycles/KB");
+}
+
+int main()
+{
+	MemorySerial serial;
+	Wio3G wio(&serial);
+	AtSerial atSerial(&serial, &wio);
+
+	static byte writeData[WRITE_SIZE];
+	for (int i = 0; i < WRITE_SIZE; i++) writeData[i] = (byte)(i * 7);
+	static byte readInput[READ_SIZE];
+	static byte readData[READ_SIZE];
+	for (int i = 0; i < READ_SIZE; i++) readInput[i] = (byte)i;
+
+	uint64_t begin = HostTest::Cycles();
+	for (int i = 0; i < REPEAT_NUM; i++) WriteBinaryBaseline(&serial, writeData, WRITE_SIZE);
+	uint64_t writeBaseline = HostTest::Cycles() - begin;
+
+	begin = HostTest::Cycles();
+	for (int i = 0; i < REPEAT_NUM; i++) atSerial.WriteBinary(writeData, WRITE_SIZE);
+	uint64_t writeBulk = HostTest::Cycles() - begin;
+	CHECK(serial.GetWrittenBytes() == 2UL * WRITE_SIZE * REPEAT_NUM);
+	unsigned long last = serial.GetWrittenBytes() - 1;
+	CHECK(serial.GetSink()[last % MemorySerial::SINK_SIZE] == writeData[WRITE_SIZE - 1]);
+
+	begin = HostTest::Cycles();
+	for (int i = 0; i < REPEAT_NUM; i++) {
+		serial.SetInput(readInput, READ_SIZE);
+		CHECK(ReadBinaryBaseline(&serial, readData, READ_SIZE, 500));
+	}
+	uint64_t readBaseline = HostTest::Cycles() - begin;
+	CHECK(readData[READ_SIZE - 1] == readInput[READ_SIZE - 1]);
+
+	begin = HostTest::Cycles();
+	for (int i = 0; i < REPEAT_NUM; i++) {
+		serial.SetInput(readInput, READ_SIZE);
+		CHECK(atSerial.ReadBinary(readData, READ_SIZE, 500));
+	}
+	uint64_t readBulk = HostTest::Cycles() - begin;
+	CHECK(serial.GetInputRemain() == 0);
+
+	Report("write_binary_per_byte", writeBaseline, (unsigned long)WRITE_SIZE * REPEAT_NUM);
+	Report("write_binary_bulk", writeBulk, (unsigned long)WRITE_SIZE * REPEAT_NUM);
+	Report("read_binary_per_byte", readBaseline, (unsigned long)READ_SIZE * REPEAT_NUM);
+	Report("read_binary_bulk", readBulk, (unsigned long)READ_SIZE * REPEAT_NUM);
+
+	CHECK(writeBulk < writeBaseline);
+	CHECK(readBulk < readBaseline);
+
+	return HostTest::Result();
+}
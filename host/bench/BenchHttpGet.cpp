@@ -0,0 +1,127 @@
+// Streaming HttpGet for bodies of 1 KB to 1 MB.
+// Parser: host MB/s of AtSerial reading the body after CONNECT, with Content-Length (ReadBinary) and without (ReadBinaryUntil OK).
+// Link: MB/s of HttpGet(url, consumer) end to end on the simulator at 921600 baud, in virtual time.
+
+#include "HostTest.h"
+#include "MemorySerial.h"
+#include "Internal/AtSerial.h"
+#include <stdio.h>
+#include <time.h>
+#include <string>
+
+#define PARSER_BYTES	(16 * 1024 * 1024)	// Per measurement, over repetitions.
+
+struct Sink {
+	unsigned long Bytes;
+	unsigned long Sum;
+};
+
+static bool Consume(const byte* data, int dataSize, void* context)
+{
+	Sink* sink = (Sink*)context;
+	sink->Bytes += dataSize;
+	sink->Sum += data[0] + data[dataSize - 1];
+
+	return true;
+}
+
+static std::string MakeBody(int size)
+{
+	std::string body;
+	body.reserve(size);
+	for (int i = 0; i < size; i++) body.push_back("0123456789abcdef\r\n"[i % 18]);
+
+	return body;
+}
+
+static double RealSeconds()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+class BodyServer : public ModemSimulator::HttpServer
+{
+public:
+	std::string Body;
+	bool ContentLength;
+
+	virtual int OnRequest(const char* method, const std::string& url, const std::string& request, std::string* body, int* contentLength)
+	{
+		*body = Body;
+		*contentLength = ContentLength ? Body.size() : -1;
+		return 200;
+	}
+};
+
+static void MeasureParser(int size, bool contentLength)
+{
+	MemorySerial serial;
+	Wio3G wio(&serial);
+	AtSerial atSerial(&serial, &wio);
+
+	std::string stream = MakeBody(size) + "\r\nOK\r\n";
+	int repeat = PARSER_BYTES / size;
+
+	Sink sink = { 0, 0 };
+	double begin = RealSeconds();
+	uint64_t beginCycles = HostTest::Cycles();
+	for (int i = 0; i < repeat; i++) {
+		serial.SetInput((const byte*)stream.data(), stream.size());
+		bool stopped;
+		if (contentLength) {
+			CHECK(atSerial.ReadBinary(size, Consume, &sink, 1000, &stopped));
+		}
+		else {
+			CHECK(atSerial.ReadBinaryUntil("\r\nOK\r\n", Consume, &sink, 1000, &stopped) == size);
+		}
+	}
+	uint64_t cycles = HostTest::Cycles() - beginCycles;
+	double elapsed = RealSeconds() - begin;
+	CHECK(sink.Bytes == (unsigned long)size * repeat);
+
+	char name[60];
+	snprintf(name, sizeof (name), "http_parser_%s_%d", contentLength ? "length" : "until_ok", size);
+	HostTest::Report(name, (double)size * repeat / elapsed / 1e6, "MB/s");
+	snprintf(name, sizeof (name), "http_parser_%s_cycles_%d", contentLength ? "length" : "until_ok", size);
+	HostTest::Report(name, (double)cycles / ((double)size * repeat), "cycles/byte");
+}
+
+static void MeasureLink(int size, bool contentLength)
+{
+	ModemSimulator sim;
+	BodyServer server;
+	server.Body = MakeBody(size);
+	server.ContentLength = contentLength;
+	sim.SetHttpServer(&server);
+	Wio3G wio(sim.GetSerial());
+	CHECK(wio.SetBaudRate(921600));
+	CHECK(HostTest::BringUp(&wio));
+
+	Sink sink = { 0, 0 };
+	unsigned long begin = micros();
+	CHECK(wio.HttpGet("http://example.com/bundle", Consume, &sink) == size);
+	unsigned long elapsed = micros() - begin;
+	CHECK(sink.Bytes == (unsigned long)size);
+
+	char name[60];
+	snprintf(name, sizeof (name), "http_get_921600_%s_%d", contentLength ? "length" : "until_ok", size);
+	HostTest::Report(name, (double)size / elapsed, "MB/s");
+}
+
+int main()
+{
+	static const int sizes[] = { 1024, 16 * 1024, 256 * 1024, 1024 * 1024 };
+
+	for (unsigned i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+		MeasureParser(sizes[i], true);
+		MeasureParser(sizes[i], false);
+	}
+	for (unsigned i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+		MeasureLink(sizes[i], true);
+		MeasureLink(sizes[i], false);
+	}
+
+	return HostTest::Result();
+}
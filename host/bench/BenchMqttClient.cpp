@@ -0,0 +1,143 @@
+// AT commands per MQTT packet through Client, read the way PubSubClient reads: available() until a byte is there, then read() per byte.
+// A broker on the simulator accepts CONNECT and pushes PUBLISH packets. The baseline Wio3GClient (std::queue and AT+QIRD
+// on every available(), read() and peek()) is compared with Wio3GClient.
+
+#include "HostTest.h"
+#include "Wio3GClient.h"
+#include <stdio.h>
+#include <string.h>
+#include <queue>
+#include <string>
+
+#define PUBLISH_NUM			(20)
+#define PUBLISH_INTERVAL	(200)
+#define PAYLOAD_SIZE		(60)
+#define READ_TIMEOUT		(15000)
+
+// Wio3GClient before the ring buffer, receive side only.
+class BaselineClient : public Client
+{
+private:
+	Wio3G* _Wio;
+	int _ConnectId;
+	byte _ReceiveBuffer[1500];
+	std::queue<byte> _ReceiveQueue;
+
+public:
+	BaselineClient(Wio3G* wio) : _Wio(wio), _ConnectId(-1) {}
+	virtual int connect(IPAddress ip, uint16_t port) { return 0; }
+	virtual int connect(const char* host, uint16_t port) { _ConnectId = _Wio->SocketOpen(host, port, WIO_TCP); return _ConnectId >= 0 ? 1 : -2; }
+	virtual size_t write(uint8_t data) { return write(&data, 1); }
+	virtual size_t write(const uint8_t* buf, size_t size) { return _Wio->SocketSend(_ConnectId, buf, size) ? size : 0; }
+	virtual int available()
+	{
+		int receiveSize = _Wio->SocketReceive(_ConnectId, _ReceiveBuffer, sizeof (_ReceiveBuffer));
+		for (int i = 0; i < receiveSize; i++) _ReceiveQueue.push(_ReceiveBuffer[i]);
+		return _ReceiveQueue.size();
+	}
+	virtual int read()
+	{
+		if (available() <= 0) return -1;
+		byte data = _ReceiveQueue.front();
+		_ReceiveQueue.pop();
+		return data;
+	}
+	virtual int read(uint8_t* buf, size_t size) { return 0; }
+	virtual int peek() { return available() > 0 ? _ReceiveQueue.front() : -1; }
+	virtual void flush() {}
+	virtual void stop() { _Wio->SocketClose(_ConnectId); _ConnectId = -1; }
+	virtual uint8_t connected() { return _ConnectId >= 0; }
+	virtual operator bool() { return _ConnectId >= 0; }
+};
+
+// Answers CONNECT with CONNACK, then publishes PUBLISH_NUM packets at PUBLISH_INTERVAL.
+class Broker : public ModemSimulator::SocketPeer
+{
+public:
+	virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize)
+	{
+		if (dataSize < 1 || data[0] != 0x10) return;
+
+		static const byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+		sim->SocketDeliver(connectId, connack, sizeof (connack), 50);
+
+		std::string publish;
+		publish.push_back(0x30);
+		publish.push_back(2 + 5 + PAYLOAD_SIZE);
+		publish.append("\x00\x05" "a/b/c", 7);
+		publish.append(PAYLOAD_SIZE, 'x');
+		for (int i = 0; i < PUBLISH_NUM; i++) sim->SocketDeliver(connectId, (const byte*)publish.data(), publish.size(), 100 + i * PUBLISH_INTERVAL);
+	}
+};
+
+// PubSubClient::readByte.
+static bool ReadByte(Client* client, byte* data)
+{
+	unsigned long begin = millis();
+	while (!client->available()) {
+		if (millis() - begin >= READ_TIMEOUT) return false;
+	}
+	*data = client->read();
+
+	return true;
+}
+
+// PubSubClient::readPacket for packets shorter than 128 bytes.
+static bool ReadPacket(Client* client, byte* type)
+{
+	byte length;
+	if (!ReadByte(client, type)) return false;
+	if (!ReadByte(client, &length)) return false;
+	for (int i = 0; i < length; i++) {
+		byte data;
+		if (!ReadByte(client, &data)) return false;
+	}
+
+	return true;
+}
+
+static double CommandsPerPacket(bool baseline)
+{
+	ModemSimulator sim;
+	Broker broker;
+	sim.SetSocketPeer(&broker);
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+
+	BaselineClient baselineClient(&wio);
+	Wio3GClient wioClient(&wio);
+	Client* client = baseline ? (Client*)&baselineClient : (Client*)&wioClient;
+
+	CHECK(client->connect("broker.example.com", 1883) == 1);
+	sim.ClearCommandLog();
+
+	static const byte connect[] = { 0x10, 0x0c, 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02, 0x00, 0x3c, 0x00, 0x00 };
+	client->write(connect, sizeof (connect));
+	client->flush();
+
+	byte type;
+	CHECK(ReadPacket(client, &type) && type == 0x20);
+	int publishNum = 0;
+	while (publishNum < PUBLISH_NUM && ReadPacket(client, &type)) {
+		if (type == 0x30) publishNum++;
+	}
+	CHECK(publishNum == PUBLISH_NUM);
+
+	int commandNum = sim.GetCommandLog().size();
+	client->stop();
+
+	return (double)commandNum / (1 + PUBLISH_NUM);
+}
+
+int main()
+{
+	double before = CommandsPerPacket(true);
+	double after = CommandsPerPacket(false);
+
+	HostTest::Report("mqtt_commands_per_packet_baseline", before, "commands");
+	HostTest::Report("mqtt_commands_per_packet", after, "commands");
+
+	CHECK(after < before);
+
+	return HostTest::Result();
+}
@@ -0,0 +1,72 @@
+// Status heartbeat (IMEI, IMSI, phone number, signal strength, CS and PS registration) as one Query line
+// against the separate getters, for several per-command latencies of the module.
+
+#include "HostTest.h"
+#include <stdio.h>
+
+#define HEARTBEAT_NUM	(20)
+
+static unsigned long Separate(Wio3G* wio)
+{
+	char imei[16];
+	char imsi[16];
+	char number[21];
+	unsigned long begin = micros();
+	CHECK(wio->GetIMEI(imei, sizeof (imei)) == 15);
+	CHECK(wio->GetIMSI(imsi, sizeof (imsi)) == 15);
+	CHECK(wio->GetPhoneNumber(number, sizeof (number)) >= 1);
+	CHECK(wio->GetReceivedSignalStrength() == -73);
+	CHECK(wio->WaitForCSRegistration(0));
+	CHECK(wio->WaitForPSRegistration(0));
+
+	return micros() - begin;
+}
+
+static unsigned long Batched(Wio3G* wio)
+{
+	Wio3G::QueryResult result;
+	unsigned long begin = micros();
+	CHECK(wio->Query(Wio3G::QUERY_IMEI | Wio3G::QUERY_IMSI | Wio3G::QUERY_PHONE_NUMBER | Wio3G::QUERY_RECEIVED_SIGNAL_STRENGTH | Wio3G::QUERY_CS_REGISTRATION | Wio3G::QUERY_PS_REGISTRATION, &result));
+	unsigned long elapsed = micros() - begin;
+	CHECK(result.ReceivedSignalStrength == -73);
+	CHECK(result.PSRegistrationStatus == 1);
+
+	return elapsed;
+}
+
+int main()
+{
+	static const unsigned long latencies[] = { 2000, 20000, 50000 };
+
+	for (unsigned i = 0; i < sizeof (latencies) / sizeof (latencies[0]); i++) {
+		ModemSimulator sim;
+		Wio3G wio(sim.GetSerial());
+		CHECK(HostTest::BringUp(&wio));
+		ModemSimulator::Timing timing = sim.GetTiming();
+		timing.CommandLatency = latencies[i];
+		sim.SetTiming(timing);
+
+		unsigned long separateTime = 0;
+		unsigned long batchedTime = 0;
+		sim.ClearCommandLog();
+		for (int j = 0; j < HEARTBEAT_NUM; j++) separateTime += Separate(&wio);
+		int separateCommands = sim.GetCommandLog().size();
+		sim.ClearCommandLog();
+		for (int j = 0; j < HEARTBEAT_NUM; j++) batchedTime += Batched(&wio);
+		int batchedCommands = sim.GetCommandLog().size();
+		CHECK(batchedCommands == HEARTBEAT_NUM);
+		CHECK(batchedTime < separateTime);
+
+		char name[60];
+		snprintf(name, sizeof (name), "heartbeat_separate_latency_%lu", latencies[i]);
+		HostTest::Report(name, (double)separateTime / HEARTBEAT_NUM, "us");
+		snprintf(name, sizeof (name), "heartbeat_query_latency_%lu", latencies[i]);
+		HostTest::Report(name, (double)batchedTime / HEARTBEAT_NUM, "us");
+		snprintf(name, sizeof (name), "heartbeat_separate_lines_%lu", latencies[i]);
+		HostTest::Report(name, (double)separateCommands / HEARTBEAT_NUM, "lines");
+		snprintf(name, sizeof (name), "heartbeat_query_lines_%lu", latencies[i]);
+		HostTest::Report(name, (double)batchedCommands / HEARTBEAT_NUM, "lines");
+	}
+
+	return HostTest::Result();
+}
@@ -0,0 +1,87 @@
+// Latency from the arrival of socket data at the module to SocketReceive returning it, and AT+QIRD per message:
+// the baseline polling (SocketReceive without timeout and delay(100) in between) and the blocking SocketReceive that waits for "recv".
+
+#include "HostTest.h"
+#include <stdio.h>
+
+#define MESSAGE_NUM			(50)
+#define POLLING_INTERVAL	(100)
+#define RECEIVE_TIMEOUT		(5000)
+
+struct Result {
+	double AverageLatency;	// [usec.]
+	unsigned long MaxLatency;	// [usec.]
+	double QirdPerMessage;
+};
+
+// Baseline SocketReceive(connectId, data, dataSize, timeout).
+static int ReceivePolling(Wio3G* wio, int connectId, byte* data, int dataSize, long timeout)
+{
+	unsigned long begin = millis();
+	int dataLength;
+	while ((dataLength = wio->SocketReceive(connectId, data, dataSize)) == 0) {
+		if (millis() - begin >= (unsigned long)timeout) return 0;
+		delay(POLLING_INTERVAL);
+	}
+
+	return dataLength;
+}
+
+static Result Measure(bool polling)
+{
+	ModemSimulator sim;
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+	int connectId = wio.SocketOpen("example.com", 7, WIO_TCP);
+	CHECK(connectId == 0);
+	sim.ClearCommandLog();
+
+	unsigned long totalLatency = 0;
+	unsigned long maxLatency = 0;
+	for (int i = 0; i < MESSAGE_NUM; i++) {
+		// Arrivals spread over the polling interval.
+		unsigned long delayTime = 20 + (i * 37) % 200;
+		unsigned long arrival = micros() + delayTime * 1000;
+		sim.SocketDeliver(connectId, "0123456789", delayTime);
+
+		byte data[100];
+		int dataLength = polling ? ReceivePolling(&wio, connectId, data, sizeof (data), RECEIVE_TIMEOUT) : wio.SocketReceive(connectId, data, sizeof (data), RECEIVE_TIMEOUT);
+		CHECK(dataLength == 10);
+
+		unsigned long latency = micros() - arrival;
+		totalLatency += latency;
+		if (latency > maxLatency) maxLatency = latency;
+	}
+
+	Result result;
+	result.AverageLatency = (double)totalLatency / MESSAGE_NUM;
+	result.MaxLatency = maxLatency;
+	result.QirdPerMessage = (double)sim.CountCommands("AT+QIRD") / MESSAGE_NUM;
+
+	return result;
+}
+
+static void Report(const char* name, const Result& result)
+{
+	char label[60];
+	snprintf(label, sizeof (label), "%s_latency_average", name);
+	HostTest::Report(label, result.AverageLatency, "us");
+	snprintf(label, sizeof (label), "%s_latency_max", name);
+	HostTest::Report(label, result.MaxLatency, "us");
+	snprintf(label, sizeof (label), "%s_qird_per_message", name);
+	HostTest::Report(label, result.QirdPerMessage, "commands");
+}
+
+int main()
+{
+	Result before = Measure(true);
+	Result after = Measure(false);
+
+	Report("receive_polling", before);
+	Report("receive_urc", after);
+
+	CHECK(after.AverageLatency < before.AverageLatency);
+	CHECK(after.QirdPerMessage < before.QirdPerMessage);
+
+	return HostTest::Result();
+}
@@ -0,0 +1,210 @@
+// Replays module output of a socket session through the response matching of ReadResponse:
+// the baseline std::string with slre_match after every byte of patterns without $, and ResponsePattern.
+// Reports host throughput in bytes/s and cycles/byte. Only the matching is measured; the serial port is not involved.
+// A second case reads a 1 KB line with a pattern that has neither ^ nor $, where the baseline retries SLRE on the whole line after every byte.
+
+#include "HostTest.h"
+#include "Internal/ResponsePattern.h"
+#include "Internal/slre.901d42c/slre.h"
+#include <string.h>
+#include <time.h>
+#include <string>
+
+#define REPLAY_NUM	(20000)
+#define LONG_LINE_LENGTH	(1024)
+#define LONG_REPLAY_NUM		(200)
+
+struct Exchange {
+	const char* Pattern;	// Pattern of the ReadResponse.
+	bool Capture;
+	const char* Output;		// Module output until the response is matched. Lines end with CR LF.
+};
+
+// AT+CSQ, a QISEND, a QISEND=0,0 ack query, a recv URC and QIRD of 64 bytes, and QISTATE, as recorded with echo off.
+static const Exchange Session[] = {
+	{ "^\\+CSQ: ([0-9]+),[0-9]+$", true, "\r\n+CSQ: 20,99\r\n" },
+	{ "^OK$", false, "\r\nOK\r\n" },
+	{ "^>", false, "\r\n> " },
+	{ "^SEND OK$", false, "\r\nSEND OK\r\n" },
+	{ "^\\+QISEND: [0-9]+,[0-9]+,([0-9]+)$", true, "\r\n+QIURC: \"recv\",0\r\n\r\n+QISEND: 1024,1024,0\r\n" },
+	{ "^OK$", false, "\r\nOK\r\n" },
+	{ "^\\+QIRD: (.*)$", true, "\r\n+QIRD: 64\r\n" },
+	{ "^OK$", false, "\r\nOK\r\n" },
+	{ "^(OK|\\+QISTATE: .*)$", true, "\r\n+QISTATE: 0,\"TCP\",\"54.250.148.252\",8010,0,2,1,0,0,\"uart1\"\r\n" },
+	{ "^(OK|\\+QISTATE: .*)$", true, "\r\nOK\r\n" },
+};
+
+#define SESSION_NUM	(sizeof (Session) / sizeof (Session[0]))
+
+static bool IsEndAnchored(const char* pattern)
+{
+	size_t length = strlen(pattern);
+	return length >= 1 && pattern[length - 1] == '$';
+}
+
+// Baseline ReadResponse: every line grows in a new std::string, and a pattern without $ is retried on it after every byte.
+static int ReplayBaseline(const Exchange& exchange, std::string* capture)
+{
+	bool endAnchored = IsEndAnchored(exchange.Pattern);
+	const char* output = exchange.Output;
+	int matchNum = 0;
+	std::string response;
+	for (const char* ptr = output; *ptr != '\0'; ptr++) {
+		response.push_back(*ptr);
+
+		bool line = false;
+		if (response.size() >= 2 && response[response.size() - 2] == '\r' && response[response.size() - 1] == '\n') {
+			response.erase(response.size() - 2);
+			line = true;
+		}
+		else if (!endAnchored && slre_match(exchange.Pattern, response.c_str(), response.size(), NULL, 0, 0) >= 1) {
+			line = true;
+		}
+		if (!line) continue;
+
+		slre_cap cap;
+		cap.len = 0;
+		if (slre_match(exchange.Pattern, response.c_str(), response.size(), &cap, 1, 0) >= 0) {
+			if (exchange.Capture) capture->assign(cap.ptr, cap.len);
+			matchNum++;
+		}
+		std::string().swap(response);
+	}
+
+	return matchNum;
+}
+
+// ReadResponse now: one Step per byte, Match per line, and SLRE only for the capture of the matched line.
+static int ReplayCompiled(const ResponsePattern& pattern, const Exchange& exchange, std::string* capture)
+{
+	char response[LONG_LINE_LENGTH + 128];
+	int length = 0;
+	int matchNum = 0;
+	ResponsePattern::State state = pattern.Begin();
+	for (const char* ptr = exchange.Output; *ptr != '\0'; ptr++) {
+		response[length++] = *ptr;
+
+		bool line = false;
+		if (length >= 2 && response[length - 2] == '\r' && response[length - 1] == '\n') {
+			length -= 2;
+			line = true;
+		}
+		else if (!pattern.IsEndAnchored()) {
+			state = pattern.Step(state, *ptr);
+			line = pattern.IsAccepted(state);
+		}
+		if (!line) continue;
+
+		if (pattern.Match(response, length)) {
+			slre_cap cap;
+			if (!exchange.Capture) matchNum++;
+			else if (slre_match(pattern.GetPattern(), response, length, &cap, 1, 0) >= 0) {
+				capture->assign(cap.ptr, cap.len);
+				matchNum++;
+			}
+		}
+		length = 0;
+		state = pattern.Begin();
+	}
+
+	return matchNum;
+}
+
+static double RealSeconds()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void Report(const char* name, unsigned long bytes, double seconds, uint64_t cycles)
+{
+	char label[60];
+	snprintf(label, sizeof (label), "%s_throughput", name);
+	HostTest::Report(label, bytes / seconds, "bytes/s");
+	snprintf(label, sizeof (label), "%s_cycles_per_byte", name);
+	HostTest::Report(label, (double)cycles / bytes, "cycles/byte");
+}
+
+int main()
+{
+	unsigned long sessionBytes = 0;
+	for (unsigned i = 0; i < SESSION_NUM; i++) sessionBytes += strlen(Session[i].Output);
+	unsigned long bytes = sessionBytes * REPLAY_NUM;
+
+	std::string capture;
+	int baselineMatchNum = 0;
+	double beginTime = RealSeconds();
+	uint64_t beginCycles = HostTest::Cycles();
+	for (int i = 0; i < REPLAY_NUM; i++) {
+		for (unsigned j = 0; j < SESSION_NUM; j++) baselineMatchNum += ReplayBaseline(Session[j], &capture);
+	}
+	uint64_t baselineCycles = HostTest::Cycles() - beginCycles;
+	double baselineTime = RealSeconds() - beginTime;
+
+	// Patterns are compiled once per ReadResponse, as the library does.
+	int compiledMatchNum = 0;
+	beginTime = RealSeconds();
+	beginCycles = HostTest::Cycles();
+	for (int i = 0; i < REPLAY_NUM; i++) {
+		for (unsigned j = 0; j < SESSION_NUM; j++) {
+			ResponsePattern pattern(Session[j].Pattern);
+			compiledMatchNum += ReplayCompiled(pattern, Session[j], &capture);
+		}
+	}
+	uint64_t compiledCycles = HostTest::Cycles() - beginCycles;
+	double compiledTime = RealSeconds() - beginTime;
+
+	// Patterns compiled beforehand, to separate the cost of Compile from the matching.
+	static ResponsePattern* patterns[SESSION_NUM];
+	for (unsigned j = 0; j < SESSION_NUM; j++) patterns[j] = new ResponsePattern(Session[j].Pattern);
+	int precompiledMatchNum = 0;
+	beginTime = RealSeconds();
+	beginCycles = HostTest::Cycles();
+	for (int i = 0; i < REPLAY_NUM; i++) {
+		for (unsigned j = 0; j < SESSION_NUM; j++) precompiledMatchNum += ReplayCompiled(*patterns[j], Session[j], &capture);
+	}
+	uint64_t precompiledCycles = HostTest::Cycles() - beginCycles;
+	double precompiledTime = RealSeconds() - beginTime;
+	for (unsigned j = 0; j < SESSION_NUM; j++) delete patterns[j];
+
+	// Every exchange ends with its match, and both see the same matches.
+	CHECK(baselineMatchNum == (int)SESSION_NUM * REPLAY_NUM);
+	CHECK(compiledMatchNum == baselineMatchNum);
+	CHECK(precompiledMatchNum == baselineMatchNum);
+
+	Report("slre_per_byte", bytes, baselineTime, baselineCycles);
+	Report("response_pattern", bytes, compiledTime, compiledCycles);
+	Report("response_pattern_precompiled", bytes, precompiledTime, precompiledCycles);
+
+	// A 1 KB line before the prompt, matched with a pattern anchored at neither end.
+	std::string longOutput = "\r\n" + std::string(LONG_LINE_LENGTH, 'x') + "\r\n> ";
+	Exchange longExchange = { ">", false, longOutput.c_str() };
+	unsigned long longBytes = longOutput.size() * LONG_REPLAY_NUM;
+
+	int longBaselineMatchNum = 0;
+	beginTime = RealSeconds();
+	beginCycles = HostTest::Cycles();
+	for (int i = 0; i < LONG_REPLAY_NUM; i++) longBaselineMatchNum += ReplayBaseline(longExchange, &capture);
+	uint64_t longBaselineCycles = HostTest::Cycles() - beginCycles;
+	double longBaselineTime = RealSeconds() - beginTime;
+
+	int longCompiledMatchNum = 0;
+	beginTime = RealSeconds();
+	beginCycles = HostTest::Cycles();
+	for (int i = 0; i < LONG_REPLAY_NUM; i++) {
+		ResponsePattern pattern(longExchange.Pattern);
+		longCompiledMatchNum += ReplayCompiled(pattern, longExchange, &capture);
+	}
+	uint64_t longCompiledCycles = HostTest::Cycles() - beginCycles;
+	double longCompiledTime = RealSeconds() - beginTime;
+
+	CHECK(longBaselineMatchNum == LONG_REPLAY_NUM);
+	CHECK(longCompiledMatchNum == longBaselineMatchNum);
+	CHECK(longCompiledCycles < longBaselineCycles);
+
+	Report("long_line_slre_per_byte", longBytes, longBaselineTime, longBaselineCycles);
+	Report("long_line_response_pattern", longBytes, longCompiledTime, longCompiledCycles);
+
+	return HostTest::Result();
+}
@@ -0,0 +1,56 @@
+#include "HostTest.h"
+
+#include <stdio.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+int HostTest::_FailureNum = 0;
+
+bool HostTest::Check(bool ok, const char* expression, const char* file, int line)
+{
+	if (!ok) {
+		printf("%s:%d: CHECK(%s) failed\n", file, line, expression);
+		_FailureNum++;
+	}
+
+	return ok;
+}
+
+int HostTest::Result()
+{
+	if (_FailureNum >= 1) {
+		printf("%d check(s) failed\n", _FailureNum);
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
+
+bool HostTest::BringUp(Wio3G* wio)
+{
+	wio->Init();
+	wio->PowerSupplyCellular(true);
+	delay(500);
+	if (!wio->TurnOnOrReset()) return false;
+	if (!wio->Activate("soracom.io", "sora", "sora")) return false;
+
+	return true;
+}
+
+void HostTest::Report(const char* name, double value, const char* unit)
+{
+	printf("BENCH %s %.6g %s\n", name, value, unit);
+}
+
+uint64_t HostTest::Cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
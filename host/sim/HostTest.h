@@ -0,0 +1,26 @@
+#pragma once
+
+#include "ModemSimulator.h"
+#include "Wio3G.h"
+
+#define CHECK(expression)	(HostTest::Check((expression) ? true : false, #expression, __FILE__, __LINE__))
+
+// Minimal test support for the host tests. A test is an executable that returns HostTest::Result() from main.
+class HostTest
+{
+private:
+	static int _FailureNum;
+
+public:
+	static bool Check(bool ok, const char* expression, const char* file, int line);
+	static int Result();
+
+	// Init, power on, TurnOnOrReset and Activate, as the examples do.
+	static bool BringUp(Wio3G* wio);
+
+	// Report a benchmark value as "BENCH <name> <value> <unit>".
+	static void Report(const char* name, double value, const char* unit);
+	// Time stamp counter of the host CPU, for cycle counts. Nanoseconds of steady_clock on other than x86.
+	static uint64_t Cycles();
+
+};
@@ -0,0 +1,86 @@
+#include "MemorySerial.h"
+
+#include <string.h>
+
+MemorySerial::MemorySerial() : _Input(NULL), _InputSize(0), _InputHead(0), _WrittenBytes(0), _WriteTimeout(0)
+{
+}
+
+//! Set the bytes to read. data is referenced, not copied.
+void MemorySerial::SetInput(const byte* data, int dataSize)
+{
+	_Input = data;
+	_InputSize = dataSize;
+	_InputHead = 0;
+}
+
+int MemorySerial::GetInputRemain() const
+{
+	return _InputSize - _InputHead;
+}
+
+unsigned long MemorySerial::GetWrittenBytes() const
+{
+	return _WrittenBytes;
+}
+
+//! Get the ring of the last written bytes. Byte n of the writes is at n % SINK_SIZE.
+const byte* MemorySerial::GetSink() const
+{
+	return _Sink;
+}
+
+void MemorySerial::Sink(const byte* data, int dataSize)
+{
+	while (dataSize > 0) {
+		int offset = _WrittenBytes % SINK_SIZE;
+		int size = SINK_SIZE - offset < dataSize ? SINK_SIZE - offset : dataSize;
+		memcpy(&_Sink[offset], data, size);
+		data += size;
+		dataSize -= size;
+		_WrittenBytes += size;
+	}
+}
+
+void MemorySerial::Begin(int baud)
+{
+}
+
+void MemorySerial::SetWriteTimeout(unsigned long timeout)
+{
+	_WriteTimeout = timeout;
+}
+
+unsigned long MemorySerial::GetWriteTimeout() const
+{
+	return _WriteTimeout;
+}
+
+void MemorySerial::Write(byte data)
+{
+	Sink(&data, 1);
+}
+
+void MemorySerial::Write(const byte* data, int dataSize)
+{
+	Sink(data, dataSize);
+}
+
+bool MemorySerial::Available() const
+{
+	return _InputHead < _InputSize;
+}
+
+byte MemorySerial::Read()
+{
+	return _InputHead < _InputSize ? _Input[_InputHead++] : 0;
+}
+
+int MemorySerial::Read(byte* data, int dataSize)
+{
+	int size = _InputSize - _InputHead < dataSize ? _InputSize - _InputHead : dataSize;
+	memcpy(data, &_Input[_InputHead], size);
+	_InputHead += size;
+
+	return size;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Internal/SerialAPI.h"
+
+// SerialAPI over memory, to measure the host cost of the parsers without the simulator.
+// Everything set with SetInput is available at once. Written bytes are copied into a ring of SINK_SIZE bytes and counted, the same for both Write overloads.
+class MemorySerial : public SerialAPI
+{
+public:
+	enum {
+		SINK_SIZE = 2048,
+	};
+
+private:
+	const byte* _Input;
+	int _InputSize;
+	int _InputHead;
+	byte _Sink[SINK_SIZE];
+	unsigned long _WrittenBytes;
+	unsigned long _WriteTimeout;
+
+	void Sink(const byte* data, int dataSize);
+
+public:
+	MemorySerial();
+
+	void SetInput(const byte* data, int dataSize);
+	int GetInputRemain() const;
+	unsigned long GetWrittenBytes() const;
+	const byte* GetSink() const;
+
+	virtual void Begin(int baud);
+	virtual void SetWriteTimeout(unsigned long timeout);
+	virtual unsigned long GetWriteTimeout() const;
+	virtual void Write(byte data);
+	virtual void Write(const byte* data, int dataSize);
+	virtual bool Available() const;
+	virtual byte Read();
+	virtual int Read(byte* data, int dataSize);
+
+};
@@ -0,0 +1,925 @@
+#include "ModemSimulator.h"
+#include "HostArduino.h"
+
+#include "Wio3GHardware.h"
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+
+#define BAUD_RATE_DEFAULT		(115200)
+#define READ_BUFFER_SIZE_DEFAULT	(2048)	// SERIAL_READ_BUFFER_SIZE of HardwareSerialAPI.
+#define IDLE_STEP				(1000000ULL)	// [nsec.] Virtual time that passes per Available() with nothing to read.
+#define PWRKEY_MIN_TIME			(100)			// [msec.]
+#define RESET_MIN_TIME			(150)			// [msec.]
+#define LINE_MAX_LENGTH			(2048)
+#define POWER_DOWN_TIME			(1000)			// [msec.] AT+QPOWD to POWERED DOWN.
+#define USSD_TIME				(500)			// [msec.]
+
+#define MSEC(ms)				((uint64_t)(ms) * 1000000ULL)
+#define USEC(us)				((uint64_t)(us) * 1000ULL)
+
+static const ModemSimulator::Timing TimingDefault = {
+	2000,	// CommandLatency
+	200,	// ChainLatency
+	500,	// StatusDelay
+	5000,	// BootTime
+	1500,	// SimReadyDelay
+	2000,	// CSRegistrationDelay
+	3000,	// PSRegistrationDelay
+	800,	// ActivateTime
+	300,	// OpenTime
+	100,	// SendAckDelay
+	1000,	// HttpTime
+};
+
+static bool StartsWith(const std::string& str, const char* prefix)
+{
+	return str.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// Split the parameters of a command at commas outside quotes, removing the quotes.
+static std::vector<std::string> SplitParameters(const std::string& str)
+{
+	std::vector<std::string> parameters;
+	std::string parameter;
+	bool inString = false;
+	for (size_t i = 0; i < str.size(); i++) {
+		char c = str[i];
+		if (c == '"') {
+			inString = !inString;
+		}
+		else if (c == ',' && !inString) {
+			parameters.push_back(parameter);
+			parameter.clear();
+		}
+		else {
+			parameter.push_back(c);
+		}
+	}
+	parameters.push_back(parameter);
+
+	return parameters;
+}
+
+static std::string Line(const std::string& str)
+{
+	return "\r\n" + str + "\r\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Serial
+
+void ModemSimulator::Serial::Begin(int baud)
+{
+	_Sim->Process();
+	_Sim->_HostBaudRate = baud;
+	_Sim->_ReadBufferSize = _Sim->_ReadBufferSizeNext;
+}
+
+void ModemSimulator::Serial::SetWriteTimeout(unsigned long timeout)
+{
+	_Sim->_WriteTimeout = timeout;
+}
+
+unsigned long ModemSimulator::Serial::GetWriteTimeout() const
+{
+	return _Sim->_WriteTimeout;
+}
+
+void ModemSimulator::Serial::Write(byte data)
+{
+	_Sim->SerialWrite(&data, 1);
+}
+
+void ModemSimulator::Serial::Write(const byte* data, int dataSize)
+{
+	_Sim->SerialWrite(data, dataSize);
+}
+
+bool ModemSimulator::Serial::Available() const
+{
+	return _Sim->SerialAvailable();
+}
+
+byte ModemSimulator::Serial::Read()
+{
+	byte data = 0;
+	_Sim->SerialRead(&data, 1);
+
+	return data;
+}
+
+int ModemSimulator::Serial::Read(byte* data, int dataSize)
+{
+	return _Sim->SerialRead(data, dataSize);
+}
+
+void ModemSimulator::Serial::SetReadBufferSize(int size)
+{
+	_Sim->_ReadBufferSizeNext = size;
+}
+
+void ModemSimulator::Serial::GetReceiveStatistics(ReceiveStatistics* statistics) const
+{
+	statistics->BufferSize = _Sim->_ReadBufferSize;
+	statistics->HighWater = _Sim->_HighWater;
+	statistics->FullSamples = _Sim->_FullSamples;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// ModemSimulator
+
+ModemSimulator::ModemSimulator() : _Serial(this), _Timing(TimingDefault), _Peer(NULL), _HttpServer(NULL), _Handler(NULL), _HandlerContext(NULL)
+{
+	_Time = HostArduino::GetNanos();
+	_Processing = false;
+
+	_HostBaudRate = BAUD_RATE_DEFAULT;
+	_ModuleBaudRate = BAUD_RATE_DEFAULT;
+	_ModuleBaudRateNext = 0;
+	_WriteTimeout = 0;
+	_NextByteTime = 0;
+	_ReadBufferSize = READ_BUFFER_SIZE_DEFAULT;
+	_ReadBufferSizeNext = READ_BUFFER_SIZE_DEFAULT;
+	_HighWater = 0;
+	_FullSamples = 0;
+	_BinaryRemain = 0;
+
+	_SupplyOn = false;
+	_On = false;
+	_PwrKeyTime = 0;
+	_ResetTime = 0;
+	_Rssi = 20;
+	_RecvUrcLost = false;
+	ResetModule();
+
+	_BytesToModule = 0;
+	_BytesFromModule = 0;
+
+	HostArduino::SetPinHooks(PinWrite, PinRead, this);
+}
+
+ModemSimulator::~ModemSimulator()
+{
+	HostArduino::SetPinHooks(NULL, NULL, NULL);
+}
+
+SerialAPI* ModemSimulator::GetSerial()
+{
+	return &_Serial;
+}
+
+void ModemSimulator::SetTiming(const Timing& timing)
+{
+	_Timing = timing;
+}
+
+const ModemSimulator::Timing& ModemSimulator::GetTiming() const
+{
+	return _Timing;
+}
+
+void ModemSimulator::SetSocketPeer(SocketPeer* peer)
+{
+	_Peer = peer;
+}
+
+void ModemSimulator::SetHttpServer(HttpServer* server)
+{
+	_HttpServer = server;
+}
+
+void ModemSimulator::SetCommandHandler(CommandHandler handler, void* context)
+{
+	_Handler = handler;
+	_HandlerContext = context;
+}
+
+void ModemSimulator::SetReceivedSignalStrength(int rssi)
+{
+	_Rssi = rssi;
+}
+
+//! Lose the "recv" URCs, as when one comes inside the response of another command. The module still counts them as reported.
+void ModemSimulator::SetRecvUrcLost(bool lost)
+{
+	_RecvUrcLost = lost;
+}
+
+uint64_t ModemSimulator::ByteTime(long baudRate) const
+{
+	return 10ULL * 1000000000ULL / baudRate;	// 8N1
+}
+
+// Run the events and move the bytes that are due by now, in time order.
+void ModemSimulator::Process()
+{
+	if (_Processing) return;	// Called back from an event or a peer.
+	_Processing = true;
+
+	uint64_t now = HostArduino::GetNanos();
+	const uint64_t never = ~0ULL;
+
+	while (true) {
+		uint64_t eventTime = _Events.empty() ? never : _Events.begin()->first;
+		bool canSend = !_Output.empty() && (int)_ReceiveBuffer.size() < _ReadBufferSize - 1;
+		uint64_t byteTime = canSend ? _NextByteTime : never;
+		if (eventTime > now && byteTime > now) break;
+
+		if (eventTime <= byteTime) {
+			std::function<void()> event = _Events.begin()->second;
+			_Events.erase(_Events.begin());
+			_Time = eventTime;
+			event();
+		}
+		else {
+			byte data = _Output.front();
+			_Output.pop_front();
+			// Nothing readable arrives when the rates differ.
+			if (_HostBaudRate == _ModuleBaudRate) {
+				_ReceiveBuffer.push_back(data);
+				_BytesFromModule++;
+				int size = _ReceiveBuffer.size();
+				if (size > _HighWater) _HighWater = size;
+				if (size >= _ReadBufferSize - 1) _FullSamples++;
+			}
+			_NextByteTime += ByteTime(_ModuleBaudRate);
+			if (_Output.empty() && _ModuleBaudRateNext > 0) {
+				_ModuleBaudRate = _ModuleBaudRateNext;
+				_ModuleBaudRateNext = 0;
+			}
+		}
+	}
+
+	// Held off by RTS: the next byte goes as soon as there is room.
+	if (!_Output.empty() && _NextByteTime < now) _NextByteTime = now;
+	_Time = now;
+	_Processing = false;
+}
+
+void ModemSimulator::Schedule(uint64_t delay, std::function<void()> event)
+{
+	_Events.insert(std::make_pair(_Time + delay, event));
+}
+
+void ModemSimulator::ResetModule()
+{
+	_Events.clear();
+	_Output.clear();
+	_ModuleBaudRate = BAUD_RATE_DEFAULT;
+	_ModuleBaudRateNext = 0;
+	_Line.clear();
+	_BinaryRemain = 0;
+	_Binary.clear();
+
+	_Status = false;
+	_Running = false;
+	_Echo = true;
+	_CRegMode = 0;
+	_CGRegMode = 0;
+	_CSStatus = 2;
+	_PSStatus = 2;
+	_SimReady = false;
+	_Active = false;
+	for (int i = 0; i < CONNECT_ID_NUM; i++) SocketReset(i);
+	_HttpRequestHeader = 0;
+	_HttpUrl.clear();
+	_HttpBody.clear();
+}
+
+void ModemSimulator::StartBoot()
+{
+	ResetModule();
+	_On = true;
+
+	Schedule(MSEC(_Timing.StatusDelay), [this]() { _Status = true; });
+	Schedule(MSEC(_Timing.BootTime), [this]() {
+		_Running = true;
+		Emit("\r\nRDY\r\n");
+		Schedule(MSEC(_Timing.SimReadyDelay), [this]() {
+			_SimReady = true;
+			Emit("\r\n+CPIN: READY\r\n");
+			SetRegistration(false, 1, _Timing.CSRegistrationDelay);
+			SetRegistration(true, 1, _Timing.PSRegistrationDelay);
+		});
+	});
+}
+
+void ModemSimulator::PowerOff()
+{
+	ResetModule();
+	_On = false;
+}
+
+void ModemSimulator::PinWrite(uint32_t pin, uint32_t value, void* context)
+{
+	ModemSimulator* sim = (ModemSimulator*)context;
+	sim->Process();
+	uint64_t now = HostArduino::GetNanos();
+
+	switch (pin) {
+	case MODULE_PWR_PIN:
+		sim->_SupplyOn = value == HIGH;
+		if (!sim->_SupplyOn) sim->PowerOff();
+		break;
+	case MODULE_PWRKEY_PIN:
+		if (value == HIGH) {
+			sim->_PwrKeyTime = now;
+		}
+		else if (sim->_SupplyOn && !sim->_On && now - sim->_PwrKeyTime >= MSEC(PWRKEY_MIN_TIME)) {
+			sim->StartBoot();
+		}
+		break;
+	case MODULE_RESET_PIN:
+		if (value == HIGH) {
+			sim->_ResetTime = now;
+		}
+		else if (sim->_On && now - sim->_ResetTime >= MSEC(RESET_MIN_TIME)) {
+			sim->StartBoot();
+		}
+		break;
+	}
+}
+
+int ModemSimulator::PinRead(uint32_t pin, void* context)
+{
+	ModemSimulator* sim = (ModemSimulator*)context;
+	if (pin != MODULE_STATUS_PIN) return -1;
+
+	sim->Process();
+	return sim->_Status ? HIGH : LOW;
+}
+
+bool ModemSimulator::SerialAvailable()
+{
+	Process();
+	if (!_ReceiveBuffer.empty()) return true;
+
+	if (_Peer != NULL) {
+		_Peer->OnIdle(this);
+		Process();
+		if (!_ReceiveBuffer.empty()) return true;
+	}
+
+	// Nothing to read yet. Let time pass up to the next byte or event, but not past the next millisecond so timeouts stay accurate.
+	uint64_t next = HostArduino::GetNanos() + IDLE_STEP;
+	if (!_Output.empty() && _NextByteTime < next) next = _NextByteTime;
+	if (!_Events.empty() && _Events.begin()->first < next) next = _Events.begin()->first;
+	HostArduino::AdvanceTo(next);
+	Process();
+
+	return !_ReceiveBuffer.empty();
+}
+
+int ModemSimulator::SerialRead(byte* data, int dataSize)
+{
+	Process();
+
+	int size = 0;
+	while (size < dataSize && !_ReceiveBuffer.empty()) {
+		data[size++] = _ReceiveBuffer.front();
+		_ReceiveBuffer.pop_front();
+	}
+	Process();	// Room for the bytes held off.
+
+	return size;
+}
+
+// The UART write blocks until the bytes are out, as HAL_UART_Transmit does.
+void ModemSimulator::SerialWrite(const byte* data, int dataSize)
+{
+	Process();
+	HostArduino::AdvanceNanos(ByteTime(_HostBaudRate) * dataSize);
+	Process();
+
+	if (!_Running || _HostBaudRate != _ModuleBaudRate) return;
+
+	_BytesToModule += dataSize;
+	for (int i = 0; i < dataSize; i++) Input(data[i]);
+}
+
+void ModemSimulator::Input(byte data)
+{
+	if (_BinaryRemain > 0) {
+		_Binary.push_back(data);
+		if (--_BinaryRemain == 0) {
+			std::string binary;
+			binary.swap(_Binary);
+			BinaryHandler handler = _BinaryHandler;
+			_BinaryHandler = NULL;
+			handler(binary);
+		}
+		return;
+	}
+
+	if (data == '\r') {
+		std::string line;
+		line.swap(_Line);
+		if (_Echo) Emit(line + "\r");
+		Execute(line);
+	}
+	else if (data != '\n' && _Line.size() < LINE_MAX_LENGTH) {
+		_Line.push_back(data);
+	}
+}
+
+void ModemSimulator::Execute(const std::string& line)
+{
+	if (line.size() < 2 || (line[0] != 'A' && line[0] != 'a') || (line[1] != 'T' && line[1] != 't')) return;
+	_CommandLog.push_back(line);
+
+	if (_Handler != NULL && _Handler(this, line, _HandlerContext)) return;
+
+	// ATE0;+IFC=2,2 runs as ATE0 and AT+IFC=2,2 with one final result.
+	std::vector<std::string> commands;
+	std::string command = "AT";
+	bool inString = false;
+	for (size_t i = 2; i < line.size(); i++) {
+		char c = line[i];
+		if (c == '"') inString = !inString;
+		if (c == ';' && !inString) {
+			commands.push_back(command);
+			command = "AT";
+			continue;
+		}
+		command.push_back(c);
+	}
+	commands.push_back(command);
+
+	std::string info;
+	std::string result;
+	for (size_t i = 0; i < commands.size(); i++) {
+		result = Command(commands[i], &info);
+		if (result != "OK") break;
+	}
+	if (result.empty()) return;	// Answered by the command itself.
+
+	Schedule(USEC(_Timing.CommandLatency + _Timing.ChainLatency * (commands.size() - 1)), [this, info, result]() { Emit(info + Line(result)); });
+}
+
+// Run one command. Information lines go to info; returns the final result code, or empty if the command answers by itself.
+std::string ModemSimulator::Command(const std::string& command, std::string* info)
+{
+	if (command == "AT") return "OK";
+	if (command == "ATE0" || command == "ATE1") {
+		_Echo = command == "ATE1";
+		return "OK";
+	}
+	if (StartsWith(command, "AT+IFC=") || StartsWith(command, "AT+QURCCFG=")) return "OK";
+
+	if (StartsWith(command, "AT+IPR=")) {
+		long baudRate = atol(&command[7]);
+		if (baudRate != 115200 && baudRate != 230400 && baudRate != 460800 && baudRate != 921600) return "ERROR";
+		_ModuleBaudRateNext = baudRate;
+		return "OK";
+	}
+
+	if (command == "AT+GSN") {
+		*info += Line("865473030000001");
+		return "OK";
+	}
+	if (command == "AT+CIMI") {
+		if (!_SimReady) return "+CME ERROR: 10";
+		*info += Line("440103000000001");
+		return "OK";
+	}
+	if (command == "AT+CNUM") {
+		if (!_SimReady) return "+CME ERROR: 10";
+		*info += Line("+CNUM: ,\"08012345678\",129");
+		return "OK";
+	}
+	if (command == "AT+CSQ") {
+		char str[20];
+		sprintf(str, "+CSQ: %d,99", _Rssi);
+		*info += Line(str);
+		return "OK";
+	}
+	if (command == "AT+CPIN?") {
+		if (!_SimReady) return "+CME ERROR: 14";	// SIM busy.
+		*info += Line("+CPIN: READY");
+		return "OK";
+	}
+	if (command == "AT+QLTS=1") {
+		*info += Line("+QLTS: \"2026/10/17,03:04:05+36,0\"");
+		return "OK";
+	}
+
+	if (StartsWith(command, "AT+CREG") || StartsWith(command, "AT+CGREG")) {
+		bool ps = StartsWith(command, "AT+CGREG");
+		const char* parameter = &command[ps ? 8 : 7];
+		if (strcmp(parameter, "?") == 0) {
+			*info += Line(RegistrationLine(ps, false));
+			return "OK";
+		}
+		if (parameter[0] != '=') return "ERROR";
+		int mode = atoi(&parameter[1]);
+		if (mode < 0 || 2 < mode) return "ERROR";
+		(ps ? _CGRegMode : _CRegMode) = mode;
+		return "OK";
+	}
+
+	if (StartsWith(command, "AT+CUSD=")) {
+		std::vector<std::string> parameters = SplitParameters(command.substr(8));
+		if (parameters.size() < 2) return "ERROR";
+		Emit(Line("+CUSD: 0,\"" + parameters[1] + "\",15"), USSD_TIME);
+		return "OK";
+	}
+
+	if (command == "AT+QPOWD") {
+		Reply(Line("OK"));
+		Schedule(MSEC(POWER_DOWN_TIME), [this]() {
+			Emit(Line("POWERED DOWN"));
+			Schedule(_Output.size() * ByteTime(_ModuleBaudRate), [this]() { PowerOff(); });
+		});
+		return "";
+	}
+
+	if (StartsWith(command, "AT+QI")) return SocketCommand(command, info);
+	if (StartsWith(command, "AT+QHTTP") || StartsWith(command, "AT+QSSL")) return HttpCommand(command, info);
+
+	return "ERROR";
+}
+
+std::string ModemSimulator::SocketCommand(const std::string& command, std::string* info)
+{
+	if (StartsWith(command, "AT+QICSGP=")) return "OK";
+	if (command == "AT+QIGETERROR") {
+		*info += Line("+QIGETERROR: 0,\"No error\"");
+		return "OK";
+	}
+
+	if (command == "AT+QIACT=1") {
+		if (_PSStatus != 1 && _PSStatus != 5) return "ERROR";
+		Schedule(MSEC(_Timing.ActivateTime), [this]() {
+			_Active = true;
+			Emit(Line("OK"));
+		});
+		return "";
+	}
+	if (command == "AT+QIACT?") {
+		if (_Active) *info += Line("+QIACT: 1,1,1,\"10.160.0.2\"");
+		return "OK";
+	}
+	if (command == "AT+QIDEACT=1") {
+		_Active = false;
+		for (int i = 0; i < CONNECT_ID_NUM; i++) {
+			if (_Sockets[i].Open && _Peer != NULL) _Peer->OnClose(this, i);
+			SocketReset(i);
+		}
+		return "OK";
+	}
+
+	if (StartsWith(command, "AT+QIOPEN=")) {
+		std::vector<std::string> parameters = SplitParameters(command.substr(10));
+		if (parameters.size() < 5) return "ERROR";
+		int connectId = atoi(parameters[1].c_str());
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId || _Sockets[connectId].Open) return "ERROR";
+		std::string type = parameters[2];
+		std::string host = parameters[3];
+		int port = atoi(parameters[4].c_str());
+
+		Reply(Line("OK"));
+		Schedule(MSEC(_Timing.OpenTime), [this, connectId, type, host, port]() {
+			int err = 0;
+			if (!_Active) err = 561;	// PDP context not activated.
+			else if (_Peer != NULL) err = _Peer->OnOpen(this, connectId, type.c_str(), host.c_str(), port);
+			if (err == 0) {
+				Socket& socket = _Sockets[connectId];
+				SocketReset(connectId);
+				socket.Open = true;
+				socket.Udp = type == "UDP";
+				socket.Host = host;
+				socket.Port = port;
+			}
+			char str[30];
+			sprintf(str, "+QIOPEN: %d,%d", connectId, err);
+			Emit(Line(str));
+		});
+		return "";
+	}
+
+	if (StartsWith(command, "AT+QICLOSE=")) {
+		int connectId = atoi(&command[11]);
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId) return "ERROR";
+		if (_Sockets[connectId].Open && _Peer != NULL) _Peer->OnClose(this, connectId);
+		SocketReset(connectId);
+		return "OK";
+	}
+
+	if (command == "AT+QISTATE?") {
+		for (int i = 0; i < CONNECT_ID_NUM; i++) {
+			const Socket& socket = _Sockets[i];
+			if (!socket.Open) continue;
+			char str[200];
+			snprintf(str, sizeof (str), "+QISTATE: %d,\"%s\",\"%s\",%d,0,2,1,%d,0,\"uart1\"", i, socket.Udp ? "UDP" : "TCP", socket.Host.c_str(), socket.Port, i);
+			*info += Line(str);
+		}
+		return "OK";
+	}
+
+	if (StartsWith(command, "AT+QISEND=")) {
+		std::vector<std::string> parameters = SplitParameters(command.substr(10));
+		int connectId = atoi(parameters[0].c_str());
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId || !_Sockets[connectId].Open) return "ERROR";
+		Socket& socket = _Sockets[connectId];
+		if (parameters.size() >= 2 && atoi(parameters[1].c_str()) == 0) {
+			char str[60];
+			sprintf(str, "+QISEND: %lu,%lu,%lu", socket.SentBytes, socket.AckedBytes, socket.SentBytes - socket.AckedBytes);
+			*info += Line(str);
+			return "OK";
+		}
+		int dataSize = parameters.size() >= 2 ? atoi(parameters[1].c_str()) : 0;
+		if (dataSize < 0 || 1460 < dataSize) return "ERROR";
+
+		Reply("> ");
+		ExpectBinary(dataSize, [this, connectId](const std::string& data) {
+			Socket& socket = _Sockets[connectId];
+			if (!socket.Open) {
+				Reply(Line("SEND FAIL"));
+				return;
+			}
+			socket.SentBytes += data.size();
+			Reply(Line("SEND OK"));
+			unsigned long size = data.size();
+			Schedule(MSEC(_Timing.SendAckDelay), [this, connectId, size]() {
+				if (_Sockets[connectId].Open) _Sockets[connectId].AckedBytes += size;
+			});
+			if (_Peer != NULL) _Peer->OnSend(this, connectId, (const byte*)data.data(), data.size());
+		});
+		return "";
+	}
+
+	if (StartsWith(command, "AT+QIRD=")) {
+		std::vector<std::string> parameters = SplitParameters(command.substr(8));
+		int connectId = atoi(parameters[0].c_str());
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId || !_Sockets[connectId].Open) return "ERROR";
+		int readSize = parameters.size() >= 2 ? atoi(parameters[1].c_str()) : 1500;
+		if (readSize <= 0 || 1500 < readSize) return "ERROR";
+
+		Socket& socket = _Sockets[connectId];
+		std::string data;
+		while (!socket.Received.empty() && (int)data.size() < readSize) {
+			const std::string& front = socket.Received.front();
+			size_t size = front.size() - socket.ReceivedHead;
+			if (size > readSize - data.size()) size = readSize - data.size();
+			data.append(front, socket.ReceivedHead, size);
+			socket.ReceivedHead += size;
+			// A datagram is read at once. The rest of a long one is lost, as on the module.
+			if (socket.ReceivedHead >= front.size() || socket.Udp) {
+				socket.Received.pop_front();
+				socket.ReceivedHead = 0;
+			}
+			if (socket.Udp) break;
+		}
+		if (socket.Received.empty()) socket.RecvNotified = false;
+
+		char str[20];
+		sprintf(str, "+QIRD: %d", (int)data.size());
+		std::string response = Line(str);
+		if (data.size() >= 1) response += data + "\r\n";
+		Reply(response + Line("OK"));
+		return "";
+	}
+
+	return "ERROR";
+}
+
+std::string ModemSimulator::HttpCommand(const std::string& command, std::string* info)
+{
+	if (StartsWith(command, "AT+QSSLCFG=")) return "OK";
+	if (StartsWith(command, "AT+QHTTPCFG=")) {
+		std::vector<std::string> parameters = SplitParameters(command.substr(12));
+		if (parameters[0] == "requestheader" && parameters.size() >= 2) _HttpRequestHeader = atoi(parameters[1].c_str());
+		return "OK";
+	}
+
+	if (StartsWith(command, "AT+QHTTPURL=")) {
+		int urlSize = atoi(&command[12]);
+		if (urlSize <= 0) return "ERROR";
+		Reply(Line("CONNECT"));
+		ExpectBinary(urlSize, [this](const std::string& url) {
+			_HttpUrl = url;
+			Reply(Line("OK"));
+		});
+		return "";
+	}
+
+	if (command == "AT+QHTTPGET" || StartsWith(command, "AT+QHTTPPOST=")) {
+		bool post = command != "AT+QHTTPGET";
+		if (!_Active || _HttpUrl.empty()) return "ERROR";
+
+		std::function<void(const std::string&)> request = [this, post](const std::string& data) {
+			Schedule(MSEC(_Timing.HttpTime), [this, post, data]() {
+				int status = 404;
+				int contentLength = 0;
+				_HttpBody.clear();
+				if (_HttpServer != NULL) status = _HttpServer->OnRequest(post ? "POST" : "GET", _HttpUrl, data, &_HttpBody, &contentLength);
+				else contentLength = 0;
+				char str[60];
+				if (contentLength >= 0) sprintf(str, "+QHTTP%s: 0,%d,%d", post ? "POST" : "GET", status, contentLength);
+				else sprintf(str, "+QHTTP%s: 0,%d", post ? "POST" : "GET", status);
+				Emit(Line(str));
+			});
+		};
+
+		if (!post) {
+			Reply(Line("OK"));
+			request("");
+			return "";
+		}
+
+		int dataSize = atoi(&command[13]);
+		if (dataSize <= 0) return "ERROR";
+		size_t comma = command.find(',');
+		int inputTime = comma != std::string::npos ? atoi(&command[comma + 1]) : 60;
+		Reply(Line("CONNECT"));
+		// The body is given up when it has not all come within <input_time>, and nothing is sent.
+		std::shared_ptr<bool> received = std::make_shared<bool>(false);
+		ExpectBinary(dataSize, [this, request, received](const std::string& data) {
+			*received = true;
+			Reply(Line("OK"));
+			request(data);
+		});
+		Schedule(MSEC(inputTime * 1000UL), [this, received]() {
+			if (*received) return;
+			_BinaryRemain = 0;
+			_Binary.clear();
+			_BinaryHandler = NULL;
+			Emit(Line("+CME ERROR: 702"));	// HTTP(S) timeout
+		});
+		return "";
+	}
+
+	if (command == "AT+QHTTPREAD") {
+		Reply(Line("CONNECT") + _HttpBody + Line("OK") + Line("+QHTTPREAD: 0"));
+		return "";
+	}
+
+	return "ERROR";
+}
+
+std::string ModemSimulator::RegistrationLine(bool ps, bool unsolicited) const
+{
+	int mode = ps ? _CGRegMode : _CRegMode;
+	int status = ps ? _PSStatus : _CSStatus;
+
+	char str[60];
+	int length = unsolicited ? sprintf(str, "+C%sREG: %d", ps ? "G" : "", status) : sprintf(str, "+C%sREG: %d,%d", ps ? "G" : "", mode, status);
+	if (mode == 2 && (status == 1 || status == 5)) sprintf(&str[length], ",\"1A2B\",\"01C3D4E5\",2");	// <AcT> 2 is UTRAN.
+
+	return str;
+}
+
+void ModemSimulator::SetRegistrationInternal(bool ps, int status)
+{
+	(ps ? _PSStatus : _CSStatus) = status;
+	if ((ps ? _CGRegMode : _CRegMode) >= 1) Emit(Line(RegistrationLine(ps, true)));
+}
+
+void ModemSimulator::SocketReset(int connectId)
+{
+	Socket& socket = _Sockets[connectId];
+	socket.Open = false;
+	socket.Udp = false;
+	socket.Host.clear();
+	socket.Port = 0;
+	socket.Received.clear();
+	socket.ReceivedHead = 0;
+	socket.RecvNotified = false;
+	socket.SentBytes = 0;
+	socket.AckedBytes = 0;
+}
+
+//! Send data to the MCU after the command latency.
+void ModemSimulator::Reply(const std::string& data)
+{
+	Schedule(USEC(_Timing.CommandLatency), [this, data]() { Emit(data); });
+}
+
+//! Send data to the MCU after delay [msec.], e.g. an unsolicited result code.
+void ModemSimulator::Emit(const std::string& data, unsigned long delay)
+{
+	if (delay > 0) {
+		Schedule(MSEC(delay), [this, data]() { Emit(data); });
+		return;
+	}
+	if (!_Running) return;
+
+	if (_Output.empty() && _NextByteTime < _Time + ByteTime(_ModuleBaudRate)) _NextByteTime = _Time + ByteTime(_ModuleBaudRate);
+	_Output.insert(_Output.end(), data.begin(), data.end());
+}
+
+//! Take the next dataSize bytes from the MCU as data, e.g. after the "> " prompt.
+void ModemSimulator::ExpectBinary(int dataSize, BinaryHandler handler)
+{
+	_BinaryRemain = dataSize;
+	_Binary.clear();
+	_BinaryHandler = handler;
+}
+
+void ModemSimulator::SetRegistration(bool ps, int status, unsigned long delay)
+{
+	Process();
+	Schedule(MSEC(delay), [this, ps, status]() { SetRegistrationInternal(ps, status); });
+}
+
+void ModemSimulator::DeactivatePdp(unsigned long delay)
+{
+	Process();
+	Schedule(MSEC(delay), [this]() {
+		if (!_Active) return;
+		_Active = false;
+		for (int i = 0; i < CONNECT_ID_NUM; i++) SocketReset(i);
+		Emit(Line("+QIURC: \"pdpdeact\",1"));
+	});
+}
+
+//! Data from the network arriving at the module socket after delay [msec.].
+void ModemSimulator::SocketDeliver(int connectId, const byte* data, int dataSize, unsigned long delay)
+{
+	Process();
+	std::string str((const char*)data, dataSize);
+	Schedule(MSEC(delay), [this, connectId, str]() {
+		Socket& socket = _Sockets[connectId];
+		if (!socket.Open) return;
+		socket.Received.push_back(str);
+		if (socket.RecvNotified) return;
+		socket.RecvNotified = true;
+		if (_RecvUrcLost) return;
+		char line[30];
+		sprintf(line, "+QIURC: \"recv\",%d", connectId);
+		Emit(Line(line));
+	});
+}
+
+void ModemSimulator::SocketDeliver(int connectId, const char* data, unsigned long delay)
+{
+	SocketDeliver(connectId, (const byte*)data, strlen(data), delay);
+}
+
+void ModemSimulator::SocketCloseRemote(int connectId, unsigned long delay)
+{
+	Process();
+	Schedule(MSEC(delay), [this, connectId]() {
+		if (!_Sockets[connectId].Open) return;
+		char line[30];
+		sprintf(line, "+QIURC: \"closed\",%d", connectId);
+		Emit(Line(line));
+	});
+}
+
+bool ModemSimulator::IsSocketOpen(int connectId) const
+{
+	return _Sockets[connectId].Open;
+}
+
+unsigned long ModemSimulator::GetSocketSentBytes(int connectId) const
+{
+	return _Sockets[connectId].SentBytes;
+}
+
+unsigned long ModemSimulator::GetSocketAckedBytes(int connectId) const
+{
+	return _Sockets[connectId].AckedBytes;
+}
+
+bool ModemSimulator::IsRunning() const
+{
+	return _Running;
+}
+
+long ModemSimulator::GetBaudRate() const
+{
+	return _ModuleBaudRate;
+}
+
+const std::vector<std::string>& ModemSimulator::GetCommandLog() const
+{
+	return _CommandLog;
+}
+
+//! Count the commands in the log that start with prefix.
+int ModemSimulator::CountCommands(const char* prefix) const
+{
+	int count = 0;
+	for (size_t i = 0; i < _CommandLog.size(); i++) {
+		if (StartsWith(_CommandLog[i], prefix)) count++;
+	}
+
+	return count;
+}
+
+void ModemSimulator::ClearCommandLog()
+{
+	_CommandLog.clear();
+}
+
+unsigned long ModemSimulator::GetBytesToModule() const
+{
+	return _BytesToModule;
+}
+
+unsigned long ModemSimulator::GetBytesFromModule() const
+{
+	return _BytesFromModule;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Internal/SerialAPI.h"
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Quectel EC21 simulator that answers the AT commands of the library through a SerialAPI, on the virtual clock of HostArduino.
+// Bytes move at the UART rate in both directions, the MCU receive buffer holds the module off with RTS when full,
+// and every command answers after a latency. The power pins boot the module like the board does.
+class ModemSimulator
+{
+public:
+	enum {
+		CONNECT_ID_NUM = 12,
+	};
+
+	struct Timing {
+		unsigned long CommandLatency;		// [usec.] From the CR of a command to its response.
+		unsigned long ChainLatency;			// [usec.] Added for each further command of a ; chain.
+		unsigned long StatusDelay;			// [msec.] From PWRKEY or RESET_N to STATUS high.
+		unsigned long BootTime;				// [msec.] From PWRKEY or RESET_N to RDY.
+		unsigned long SimReadyDelay;		// [msec.] From RDY to +CPIN: READY.
+		unsigned long CSRegistrationDelay;	// [msec.] From +CPIN: READY to +CREG: 1.
+		unsigned long PSRegistrationDelay;	// [msec.] From +CPIN: READY to +CGREG: 1.
+		unsigned long ActivateTime;			// [msec.] AT+QIACT=1 to OK.
+		unsigned long OpenTime;				// [msec.] AT+QIOPEN to +QIOPEN.
+		unsigned long SendAckDelay;			// [msec.] From SEND OK to the data being acknowledged by the peer.
+		unsigned long HttpTime;				// [msec.] AT+QHTTPGET/AT+QHTTPPOST to +QHTTPGET/+QHTTPPOST.
+	};
+
+	// The network side of the module sockets.
+	class SocketPeer
+	{
+	public:
+		virtual ~SocketPeer() {}
+		// Return 0 to accept, or the <err> of +QIOPEN such as 565 (DNS parse failed) or 566 (connect failed).
+		virtual int OnOpen(ModemSimulator* sim, int connectId, const char* type, const char* host, int port) { return 0; }
+		virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize) {}
+		virtual void OnClose(ModemSimulator* sim, int connectId) {}
+		// Called while the MCU waits for the module, before virtual time moves on.
+		virtual void OnIdle(ModemSimulator* sim) {}
+	};
+
+	// The server behind AT+QHTTPGET and AT+QHTTPPOST.
+	class HttpServer
+	{
+	public:
+		virtual ~HttpServer() {}
+		// request is the POST data, with the header when requestheader is 1. Returns the HTTP status code.
+		// Set *contentLength to -1 to leave it out of +QHTTPGET, as the module does without Content-Length.
+		virtual int OnRequest(const char* method, const std::string& url, const std::string& request, std::string* body, int* contentLength) = 0;
+	};
+
+	// Called with every command line before the built-in commands. Return false to pass it on.
+	typedef bool (*CommandHandler)(ModemSimulator* sim, const std::string& command, void* context);
+
+	typedef std::function<void(const std::string& data)> BinaryHandler;
+
+private:
+	class Serial : public SerialAPI
+	{
+	private:
+		ModemSimulator* _Sim;
+
+	public:
+		Serial(ModemSimulator* sim) : _Sim(sim) {}
+		virtual void Begin(int baud);
+		virtual void SetWriteTimeout(unsigned long timeout);
+		virtual unsigned long GetWriteTimeout() const;
+		virtual void Write(byte data);
+		virtual void Write(const byte* data, int dataSize);
+		virtual bool Available() const;
+		virtual byte Read();
+		virtual int Read(byte* data, int dataSize);
+		virtual void SetReadBufferSize(int size);
+		virtual void GetReceiveStatistics(ReceiveStatistics* statistics) const;
+	};
+
+	struct Socket {
+		bool Open;
+		bool Udp;
+		std::string Host;
+		int Port;
+		std::deque<std::string> Received;	// Datagrams, or segments of the stream.
+		size_t ReceivedHead;				// Bytes of Received.front() already read.
+		bool RecvNotified;					// "recv" is reported once until the data is read out.
+		unsigned long SentBytes;
+		unsigned long AckedBytes;
+	};
+
+	Serial _Serial;
+	Timing _Timing;
+	SocketPeer* _Peer;
+	HttpServer* _HttpServer;
+	CommandHandler _Handler;
+	void* _HandlerContext;
+
+	// Virtual time of what is being processed. Events run at their own time, which may be behind the clock.
+	uint64_t _Time;
+	bool _Processing;
+	std::multimap<uint64_t, std::function<void()> > _Events;
+
+	// UART
+	long _HostBaudRate;
+	long _ModuleBaudRate;
+	long _ModuleBaudRateNext;			// AT+IPR takes effect after the OK is sent.
+	unsigned long _WriteTimeout;
+	std::deque<byte> _Output;			// Module to MCU, not sent yet.
+	uint64_t _NextByteTime;
+	std::deque<byte> _ReceiveBuffer;	// Arrived at the MCU, not read yet.
+	int _ReadBufferSize;
+	int _ReadBufferSizeNext;
+	int _HighWater;
+	unsigned long _FullSamples;
+	std::string _Line;
+	int _BinaryRemain;
+	std::string _Binary;
+	BinaryHandler _BinaryHandler;
+
+	// Module state
+	bool _SupplyOn;
+	bool _On;
+	bool _Status;
+	bool _Running;
+	uint64_t _PwrKeyTime;
+	uint64_t _ResetTime;
+	bool _Echo;
+	int _CRegMode;
+	int _CGRegMode;
+	int _CSStatus;
+	int _PSStatus;
+	bool _SimReady;
+	bool _Active;
+	int _Rssi;
+	bool _RecvUrcLost;
+	Socket _Sockets[CONNECT_ID_NUM];
+	int _HttpRequestHeader;
+	std::string _HttpUrl;
+	std::string _HttpBody;
+
+	// Observation
+	std::vector<std::string> _CommandLog;
+	unsigned long _BytesToModule;
+	unsigned long _BytesFromModule;
+
+	static void PinWrite(uint32_t pin, uint32_t value, void* context);
+	static int PinRead(uint32_t pin, void* context);
+
+	uint64_t ByteTime(long baudRate) const;
+	void Process();
+	void Schedule(uint64_t delay, std::function<void()> event);
+	void ResetModule();
+	void StartBoot();
+	void PowerOff();
+
+	bool SerialAvailable();
+	int SerialRead(byte* data, int dataSize);
+	void SerialWrite(const byte* data, int dataSize);
+	void Input(byte data);
+	void Execute(const std::string& line);
+	std::string Command(const std::string& command, std::string* info);
+	std::string SocketCommand(const std::string& command, std::string* info);
+	std::string HttpCommand(const std::string& command, std::string* info);
+	std::string RegistrationLine(bool ps, bool unsolicited) const;
+	void SetRegistrationInternal(bool ps, int status);
+	void SocketReset(int connectId);
+
+public:
+	ModemSimulator();
+	~ModemSimulator();
+
+	SerialAPI* GetSerial();
+
+	void SetTiming(const Timing& timing);
+	const Timing& GetTiming() const;
+	void SetSocketPeer(SocketPeer* peer);
+	void SetHttpServer(HttpServer* server);
+	void SetCommandHandler(CommandHandler handler, void* context);
+	void SetReceivedSignalStrength(int rssi);
+	void SetRecvUrcLost(bool lost);
+
+	// Output of the module, for command handlers and tests.
+	void Reply(const std::string& data);
+	void Emit(const std::string& data, unsigned long delay = 0);
+	void ExpectBinary(int dataSize, BinaryHandler handler);
+
+	// Network events.
+	void SetRegistration(bool ps, int status, unsigned long delay = 0);
+	void DeactivatePdp(unsigned long delay = 0);
+	void SocketDeliver(int connectId, const byte* data, int dataSize, unsigned long delay = 0);
+	void SocketDeliver(int connectId, const char* data, unsigned long delay = 0);
+	void SocketCloseRemote(int connectId, unsigned long delay = 0);
+	bool IsSocketOpen(int connectId) const;
+	unsigned long GetSocketSentBytes(int connectId) const;
+	unsigned long GetSocketAckedBytes(int connectId) const;
+
+	bool IsRunning() const;
+	long GetBaudRate() const;
+	const std::vector<std::string>& GetCommandLog() const;
+	int CountCommands(const char* prefix) const;
+	void ClearCommandLog();
+	unsigned long GetBytesToModule() const;
+	unsigned long GetBytesFromModule() const;
+
+};
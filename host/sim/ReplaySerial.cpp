@@ -0,0 +1,203 @@
+#include "ReplaySerial.h"
+#include "HostArduino.h"
+
+#include <stdio.h>
+
+#define BAUD_RATE_DEFAULT	(115200)
+#define IDLE_STEP			(1000)	// [usec.] Longest step of the clock while waiting, so timeouts stay accurate.
+
+static int HexToInt(char ch)
+{
+	if ('0' <= ch && ch <= '9') return ch - '0';
+	if ('a' <= ch && ch <= 'f') return ch - 'a' + 10;
+	if ('A' <= ch && ch <= 'F') return ch - 'A' + 10;
+	return -1;
+}
+
+ReplaySerial::ReplaySerial() : _ReadIndex(0), _ReadHead(0), _WriteIndex(0), _WriteHead(0), _Offset(0), _MismatchCount(0), _BaudRate(BAUD_RATE_DEFAULT), _WriteTimeout(0)
+{
+}
+
+// Move the cursors past the records of the other direction.
+void ReplaySerial::SkipRecords()
+{
+	while (_ReadIndex < (int)_Records.size() && !_Records[_ReadIndex].FromModule) _ReadIndex++;
+	while (_WriteIndex < (int)_Records.size() && _Records[_WriteIndex].FromModule) _WriteIndex++;
+}
+
+// [nsec.] Time of the next byte from the module, or -1 while there is none. The bytes of a record follow each other at the UART rate.
+int64_t ReplaySerial::NextByteTime() const
+{
+	if (_ReadIndex >= (int)_Records.size()) return -1;
+	if (_WriteIndex < _ReadIndex) return -1;	// The command it answers is not written yet.
+
+	return ((int64_t)_Records[_ReadIndex].Time + _Offset) * 1000 + (int64_t)_ReadHead * ByteTime();
+}
+
+bool ReplaySerial::IsReadable() const
+{
+	int64_t time = NextByteTime();
+
+	return time >= 0 && (uint64_t)time <= HostArduino::GetNanos();
+}
+
+// [nsec.] 8N1
+int64_t ReplaySerial::ByteTime() const
+{
+	return (int64_t)1000000000 * 10 / _BaudRate;
+}
+
+//! Parse the lines of Dump(), "<micros> <- <hex>" and "<micros> -> <hex>". Empty lines are skipped. The replay starts now.
+bool ReplaySerial::Load(const char* trace)
+{
+	_Records.clear();
+
+	const char* ptr = trace;
+	while (*ptr != '\0') {
+		const char* end = strchr(ptr, '\n');
+		if (end == NULL) end = ptr + strlen(ptr);
+		std::string line(ptr, end);
+		ptr = *end == '\n' ? end + 1 : end;
+
+		if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+		if (line.empty()) continue;
+
+		unsigned long time;
+		char direction[3];
+		int length;
+		if (sscanf(line.c_str(), "%lu %2s %n", &time, direction, &length) != 2) return false;
+
+		Record record;
+		record.Time = time;
+		if (strcmp(direction, "->") == 0) record.FromModule = true;
+		else if (strcmp(direction, "<-") == 0) record.FromModule = false;
+		else return false;
+
+		const char* hex = line.c_str() + length;
+		if (*hex == '\0' || strlen(hex) % 2 != 0) return false;
+		for (; *hex != '\0'; hex += 2) {
+			int high = HexToInt(hex[0]);
+			int low = HexToInt(hex[1]);
+			if (high < 0 || low < 0) return false;
+			record.Data += (char)(high << 4 | low);
+		}
+
+		_Records.push_back(record);
+	}
+
+	_ReadIndex = 0;
+	_ReadHead = 0;
+	_WriteIndex = 0;
+	_WriteHead = 0;
+	_Offset = _Records.empty() ? 0 : (int64_t)micros() - (int64_t)_Records[0].Time;
+	_MismatchCount = 0;
+	SkipRecords();
+
+	return true;
+}
+
+bool ReplaySerial::LoadFile(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) return false;
+
+	std::string trace;
+	char buffer[4096];
+	size_t size;
+	while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) trace.append(buffer, size);
+	fclose(file);
+
+	return Load(trace.c_str());
+}
+
+//! Whether every record has been read and written.
+bool ReplaySerial::IsFinished() const
+{
+	return _ReadIndex >= (int)_Records.size() && _WriteIndex >= (int)_Records.size();
+}
+
+//! Get the number of written bytes that differ from the trace, or come after its end.
+unsigned long ReplaySerial::GetMismatchCount() const
+{
+	return _MismatchCount;
+}
+
+void ReplaySerial::Begin(int baud)
+{
+	_BaudRate = baud;
+}
+
+void ReplaySerial::SetWriteTimeout(unsigned long timeout)
+{
+	_WriteTimeout = timeout;
+}
+
+unsigned long ReplaySerial::GetWriteTimeout() const
+{
+	return _WriteTimeout;
+}
+
+void ReplaySerial::Write(byte data)
+{
+	Write(&data, 1);
+}
+
+// The records to the module are stamped before the bytes go out, and the UART write blocks until they are out, as on the board.
+void ReplaySerial::Write(const byte* data, int dataSize)
+{
+	unsigned long now = micros();
+	for (int i = 0; i < dataSize; i++) {
+		if (_WriteIndex >= (int)_Records.size()) {
+			_MismatchCount++;
+			continue;
+		}
+
+		const Record& record = _Records[_WriteIndex];
+		if ((byte)record.Data[_WriteHead] != data[i]) _MismatchCount++;
+		if (++_WriteHead >= record.Data.size()) {
+			_Offset = (int64_t)now - (int64_t)record.Time;
+			_WriteIndex++;
+			_WriteHead = 0;
+			SkipRecords();
+		}
+	}
+
+	HostArduino::AdvanceNanos(ByteTime() * dataSize);
+}
+
+// Nothing to read yet. Let time pass up to the next byte, but not past the next millisecond.
+bool ReplaySerial::Available() const
+{
+	if (IsReadable()) return true;
+
+	uint64_t next = HostArduino::GetNanos() + IDLE_STEP * 1000;
+	int64_t time = NextByteTime();
+	if (time >= 0 && (uint64_t)time < next) next = time;
+	HostArduino::AdvanceTo(next);
+
+	return IsReadable();
+}
+
+byte ReplaySerial::Read()
+{
+	byte data = 0;
+	Read(&data, 1);
+
+	return data;
+}
+
+int ReplaySerial::Read(byte* data, int dataSize)
+{
+	int size = 0;
+	while (size < dataSize && IsReadable()) {
+		const Record& record = _Records[_ReadIndex];
+		data[size++] = record.Data[_ReadHead++];
+		if (_ReadHead >= record.Data.size()) {
+			_ReadIndex++;
+			_ReadHead = 0;
+			SkipRecords();
+		}
+	}
+
+	return size;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Internal/SerialAPI.h"
+#include <string>
+#include <vector>
+
+// SerialAPI that plays back a trace printed by Wio3GSerialTrace::Dump(), on the virtual clock of HostArduino.
+// The bytes from the module arrive at their recorded times and the UART rate, counted from the last bytes to the module, so each response keeps its recorded delay after its command.
+// Bytes from the module after a record to the module are held until that record has been written. Written bytes are compared with the trace.
+// The driver must start in the state of the recording, e.g. a Wio3G just constructed for a trace recorded from one just constructed.
+class ReplaySerial : public SerialAPI
+{
+private:
+	struct Record {
+		unsigned long Time;		// [usec.] micros() of the recording.
+		bool FromModule;
+		std::string Data;
+	};
+
+	std::vector<Record> _Records;
+	int _ReadIndex;				// Record read from next, the first from the module not read out.
+	size_t _ReadHead;
+	int _WriteIndex;			// Record compared with the next write, the first to the module not written.
+	size_t _WriteHead;
+	int64_t _Offset;			// [usec.] micros() of the replay minus micros() of the recording.
+	unsigned long _MismatchCount;
+	int _BaudRate;
+	unsigned long _WriteTimeout;
+
+	void SkipRecords();
+	int64_t NextByteTime() const;
+	bool IsReadable() const;
+	int64_t ByteTime() const;
+
+public:
+	ReplaySerial();
+
+	bool Load(const char* trace);
+	bool LoadFile(const char* path);
+
+	bool IsFinished() const;
+	unsigned long GetMismatchCount() const;
+
+	virtual void Begin(int baud);
+	virtual void SetWriteTimeout(unsigned long timeout);
+	virtual unsigned long GetWriteTimeout() const;
+	virtual void Write(byte data);
+	virtual void Write(const byte* data, int dataSize);
+	virtual bool Available() const;
+	virtual byte Read();
+	virtual int Read(byte* data, int dataSize);
+
+};
@@ -0,0 +1,109 @@
+#include "TcpBridge.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define POLL_TIMEOUT	(1)		// [msec.] Real time.
+#define READ_SIZE		(1500)
+
+TcpBridge::TcpBridge() : _Awaiting(0), _OpenCount(0)
+{
+	for (int i = 0; i < ModemSimulator::CONNECT_ID_NUM; i++) _Fds[i] = -1;
+}
+
+TcpBridge::~TcpBridge()
+{
+	for (int i = 0; i < ModemSimulator::CONNECT_ID_NUM; i++) {
+		if (_Fds[i] >= 0) close(_Fds[i]);
+	}
+}
+
+int TcpBridge::OnOpen(ModemSimulator* sim, int connectId, const char* type, const char* host, int port)
+{
+	if (strcmp(type, "TCP") != 0) return 566;
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) return 566;
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof (addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (connect(fd, (sockaddr*)&addr, sizeof (addr)) != 0) {
+		close(fd);
+		return 566;	// Connect failed.
+	}
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+
+	_Fds[connectId] = fd;
+	_OpenCount++;
+
+	return 0;
+}
+
+void TcpBridge::OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize)
+{
+	if (_Fds[connectId] < 0) return;
+
+	_Awaiting |= 1 << connectId;
+	while (dataSize > 0) {
+		ssize_t size = send(_Fds[connectId], data, dataSize, MSG_NOSIGNAL);
+		if (size <= 0) return;
+		data += size;
+		dataSize -= size;
+	}
+}
+
+void TcpBridge::OnClose(ModemSimulator* sim, int connectId)
+{
+	if (_Fds[connectId] < 0) return;
+
+	close(_Fds[connectId]);
+	_Fds[connectId] = -1;
+	_Awaiting &= ~(1 << connectId);
+}
+
+void TcpBridge::OnIdle(ModemSimulator* sim)
+{
+	pollfd fds[ModemSimulator::CONNECT_ID_NUM];
+	int ids[ModemSimulator::CONNECT_ID_NUM];
+	int fdNum = 0;
+	for (int i = 0; i < ModemSimulator::CONNECT_ID_NUM; i++) {
+		if (_Fds[i] < 0) continue;
+		fds[fdNum].fd = _Fds[i];
+		fds[fdNum].events = POLLIN;
+		fds[fdNum].revents = 0;
+		ids[fdNum] = i;
+		fdNum++;
+	}
+	if (fdNum <= 0) return;
+	if (poll(fds, fdNum, _Awaiting != 0 ? POLL_TIMEOUT : 0) <= 0) return;
+
+	for (int i = 0; i < fdNum; i++) {
+		if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) continue;
+
+		byte data[READ_SIZE];
+		ssize_t size = recv(fds[i].fd, data, sizeof (data), 0);
+		_Awaiting &= ~(1 << ids[i]);
+		if (size > 0) {
+			sim->SocketDeliver(ids[i], data, size);
+		}
+		else {
+			// The server closed. The module reports it after the data already delivered.
+			close(fds[i].fd);
+			_Fds[ids[i]] = -1;
+			sim->SocketCloseRemote(ids[i]);
+		}
+	}
+}
+
+unsigned long TcpBridge::GetOpenCount() const
+{
+	return _OpenCount;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "ModemSimulator.h"
+
+// SocketPeer that connects the TCP sockets of the module to real TCP connections of the host.
+// Every open goes to 127.0.0.1 on the requested port, whatever the host name. Received data is polled while the MCU waits.
+// From a send until the first data back, each poll blocks for a real millisecond, so virtual time does not run ahead of the server.
+class TcpBridge : public ModemSimulator::SocketPeer
+{
+private:
+	int _Fds[ModemSimulator::CONNECT_ID_NUM];
+	unsigned int _Awaiting;		// Bit per connectId. Sent to, nothing received since.
+	unsigned long _OpenCount;
+
+public:
+	TcpBridge();
+	virtual ~TcpBridge();
+
+	virtual int OnOpen(ModemSimulator* sim, int connectId, const char* type, const char* host, int port);
+	virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize);
+	virtual void OnClose(ModemSimulator* sim, int connectId);
+	virtual void OnIdle(ModemSimulator* sim);
+
+	unsigned long GetOpenCount() const;
+
+};
@@ -0,0 +1,52 @@
+// ActivateAsync while PS registration takes 20 s: it follows the +CGREG URC instead of polling AT+CGREG?,
+// and starts AT+QIACT=1 as soon as the URC arrives.
+
+#include "HostTest.h"
+
+#define PS_REGISTRATION_DELAY	(20000)
+
+static Wio3G::AsyncStatus CompletedStatus = Wio3G::ASYNC_IDLE;
+
+static void OnComplete(Wio3G::AsyncStatus status, int result)
+{
+	CompletedStatus = status;
+}
+
+int main()
+{
+	ModemSimulator sim;
+	ModemSimulator::Timing timing = sim.GetTiming();
+	timing.PSRegistrationDelay = PS_REGISTRATION_DELAY;
+	sim.SetTiming(timing);
+	Wio3G wio(sim.GetSerial());
+	wio.Init();
+	wio.PowerSupplyCellular(true);
+	delay(500);
+	CHECK(wio.TurnOnOrReset());
+
+	sim.ClearCommandLog();
+	unsigned long begin = millis();
+	CHECK(wio.ActivateAsync("soracom.io", "sora", "sora", OnComplete));
+	Wio3G::RegistrationStatus registration;
+	unsigned long registeredTime = 0;
+	while (CompletedStatus != Wio3G::ASYNC_SUCCEEDED && CompletedStatus != Wio3G::ASYNC_FAILED) {
+		wio.Poll();
+		wio.GetPSRegistration(&registration);
+		if (registeredTime == 0 && registration.Status == 1) registeredTime = millis();
+		delay(1);
+	}
+	unsigned long elapsed = millis() - begin;
+	CHECK(CompletedStatus == Wio3G::ASYNC_SUCCEEDED);
+	CHECK(registeredTime != 0);
+
+	// One AT+CGREG? to start, then one per REGISTRATION_FALLBACK_INTERVAL (5 s) at most.
+	int cgregNum = sim.CountCommands("AT+CGREG?");
+	printf("%d AT+CGREG? in %lu ms\n", cgregNum, elapsed);
+	CHECK(cgregNum <= 1 + (int)(elapsed / 5000));
+	CHECK(sim.CountCommands("AT+QIACT=1") == 1);
+	// QIACT follows the URC, not the next query.
+	CHECK(millis() - registeredTime < 5000);
+	CHECK(elapsed - (registeredTime - begin) < 1000 + timing.ActivateTime);
+
+	return HostTest::Result();
+}
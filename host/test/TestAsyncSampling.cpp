@@ -0,0 +1,86 @@
+// Sensor sampling at 100 Hz from loop() while a slow QIOPEN is pending: SocketOpenAsync with Poll() keeps the rate,
+// the blocking SocketOpen stops it for the whole open.
+
+#include "HostTest.h"
+
+#define OPEN_TIME			(10000)
+#define SAMPLING_INTERVAL	(10)
+#define SAMPLING_TIME		(100)	// [usec.] Reading the sensor.
+
+static Wio3G::AsyncStatus CompletedStatus = Wio3G::ASYNC_IDLE;
+static int CompletedResult = -1;
+
+static void OnComplete(Wio3G::AsyncStatus status, int result)
+{
+	CompletedStatus = status;
+	CompletedResult = result;
+}
+
+struct Sampler {
+	unsigned long NextTime;
+	unsigned long LastTime;
+	unsigned long MaxGap;
+	unsigned long Count;
+
+	void Begin()
+	{
+		NextTime = millis();
+		LastTime = NextTime;
+		MaxGap = 0;
+		Count = 0;
+	}
+
+	void Loop()
+	{
+		unsigned long now = millis();
+		if ((long)(now - NextTime) < 0) return;
+		delayMicroseconds(SAMPLING_TIME);
+		if (now - LastTime > MaxGap) MaxGap = now - LastTime;
+		LastTime = now;
+		NextTime += SAMPLING_INTERVAL;
+		Count++;
+	}
+};
+
+int main()
+{
+	ModemSimulator sim;
+	ModemSimulator::Timing timing = sim.GetTiming();
+	timing.OpenTime = OPEN_TIME;
+	sim.SetTiming(timing);
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+
+	// Asynchronous.
+	Sampler sampler;
+	sampler.Begin();
+	unsigned long begin = millis();
+	CHECK(wio.SocketOpenAsync("example.com", 80, WIO_TCP, OnComplete));
+	while (CompletedStatus == Wio3G::ASYNC_IDLE || CompletedStatus == Wio3G::ASYNC_BUSY) {
+		sampler.Loop();
+		wio.Poll();
+		if (millis() - begin > OPEN_TIME * 2) break;
+	}
+	unsigned long elapsed = millis() - begin;
+	CHECK(CompletedStatus == Wio3G::ASYNC_SUCCEEDED);
+	CHECK(CompletedResult == 0);
+	CHECK(sim.IsSocketOpen(0));
+	CHECK(elapsed >= OPEN_TIME);
+	double rate = sampler.Count * 1000.0 / elapsed;
+	printf("async: %lu samples in %lu ms (%.1f Hz), max gap %lu ms\n", sampler.Count, elapsed, rate, sampler.MaxGap);
+	CHECK(rate >= 1000.0 / SAMPLING_INTERVAL * 0.95);
+	CHECK(sampler.MaxGap <= SAMPLING_INTERVAL * 2);
+	CHECK(wio.SocketClose(0));
+
+	// Blocking, for comparison.
+	sampler.Begin();
+	begin = millis();
+	sampler.Loop();
+	CHECK(wio.SocketOpen("example.com", 80, WIO_TCP) == 0);
+	sampler.Loop();
+	elapsed = millis() - begin;
+	printf("blocking: %lu samples in %lu ms, max gap %lu ms\n", sampler.Count, elapsed, sampler.MaxGap);
+	CHECK(sampler.MaxGap >= OPEN_TIME);
+
+	return HostTest::Result();
+}
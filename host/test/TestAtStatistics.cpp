@@ -0,0 +1,47 @@
+// AtStatistics, built with WIO_AT_STATISTICS: AT+QISEND ends at its ">" prompt, and the data after it at SEND OK.
+
+#include "HostTest.h"
+#include <string.h>
+
+static const AtStatistics::Entry* Find(Wio3G* wio, const char* command)
+{
+	for (int i = 0; i < wio->GetAtStatisticsSize(); i++) {
+		const AtStatistics::Entry* entry = wio->GetAtStatistics(i);
+		if (strcmp(entry->Command, command) == 0) return entry;
+	}
+
+	return NULL;
+}
+
+static unsigned long Count(const AtStatistics::Entry* entry)
+{
+	unsigned long count = 0;
+	for (int i = 0; i < AT_STATISTICS_BUCKET_NUM; i++) count += entry->Count[i];
+
+	return count;
+}
+
+int main()
+{
+	ModemSimulator sim;
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+	int connectId = wio.SocketOpen("example.com", 7, WIO_TCP);
+	CHECK(connectId == 0);
+
+	wio.ClearAtStatistics();
+	for (int i = 0; i < 3; i++) CHECK(wio.SocketSend(connectId, "hello"));
+	CHECK(wio.GetReceivedSignalStrength() == -73);
+
+	const AtStatistics::Entry* qisend = Find(&wio, "AT+QISEND");
+	CHECK(qisend != NULL && Count(qisend) == 3 && qisend->Timeout == 0);
+	const AtStatistics::Entry* binary = Find(&wio, "(binary)");
+	CHECK(binary != NULL && Count(binary) == 3 && binary->Timeout == 0);
+	const AtStatistics::Entry* csq = Find(&wio, "AT+CSQ");
+	CHECK(csq != NULL && Count(csq) == 1);
+	CHECK(wio.GetAtStatistics(wio.GetAtStatisticsSize()) == NULL);
+
+	CHECK(wio.SocketClose(connectId));
+
+	return HostTest::Result();
+}
@@ -0,0 +1,236 @@
+// Wio3GHttpClient against a real HTTP server on 127.0.0.1, through the simulator and TcpBridge.
+// Keep-alive across requests, pipelining, chunked and until-close bodies, and reconnecting after the server closes,
+// also when it closes an idle connection before or as the next request comes.
+
+#include "HostTest.h"
+#include "TcpBridge.h"
+#include "Wio3GHttpClient.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#define BIG_SIZE	(100000)
+
+// HTTP/1.1 server with keep-alive, one connection at a time.
+class LocalServer
+{
+private:
+	int _ListenFd;
+	int _Port;
+	std::thread _Thread;
+	std::atomic<bool> _Stop;
+
+	static std::string Response(const std::string& status, const std::string& headers, const std::string& body)
+	{
+		char length[40];
+		snprintf(length, sizeof (length), "Content-Length: %zu\r\n", body.size());
+		return "HTTP/1.1 " + status + "\r\n" + headers + length + "\r\n" + body;
+	}
+
+	// Returns false to close the connection after the response.
+	static bool Handle(const std::string& method, const std::string& path, const std::string& body, std::string* response)
+	{
+		if (path == "/hello") {
+			*response = Response("200 OK", "Content-Type: text/plain\r\n", "hello world");
+		}
+		else if (path == "/chunked") {
+			*response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n5;ext=1\r\ndefgh\r\n0\r\n\r\n";
+		}
+		else if (path == "/echo" && method == "POST") {
+			*response = Response("201 Created", "", body);
+		}
+		else if (path == "/big") {
+			std::string big;
+			for (int i = 0; i < BIG_SIZE; i++) big.push_back('a' + i % 26);
+			*response = Response("200 OK", "", big);
+		}
+		else if (path == "/close") {
+			*response = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nbye";
+			return false;
+		}
+		else {
+			*response = Response("404 Not Found", "", "");
+		}
+		return true;
+	}
+
+	void Serve(int fd)
+	{
+		std::string buffer;
+		while (!_Stop) {
+			size_t headerEnd = buffer.find("\r\n\r\n");
+			size_t bodyLength = 0;
+			if (headerEnd != std::string::npos) {
+				const char* contentLength = strcasestr(buffer.substr(0, headerEnd).c_str(), "Content-Length:");
+				if (contentLength != NULL) bodyLength = atoi(contentLength + 15);
+			}
+			if (headerEnd != std::string::npos && buffer.size() >= headerEnd + 4 + bodyLength) {
+				std::string requestLine = buffer.substr(0, buffer.find("\r\n"));
+				size_t space1 = requestLine.find(' ');
+				size_t space2 = requestLine.find(' ', space1 + 1);
+				std::string method = requestLine.substr(0, space1);
+				std::string path = requestLine.substr(space1 + 1, space2 - space1 - 1);
+				std::string body = buffer.substr(headerEnd + 4, bodyLength);
+				buffer.erase(0, headerEnd + 4 + bodyLength);
+
+				if (DropNextRequest.exchange(false)) break;	// Closed as the request came, without an answer.
+
+				std::string response;
+				bool keepAlive = Handle(method, path, body, &response);
+				send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+				if (!keepAlive) break;
+				continue;
+			}
+
+			if (buffer.empty() && CloseIdle.exchange(false)) break;
+
+			pollfd pfd = { fd, POLLIN, 0 };
+			if (poll(&pfd, 1, 10) <= 0) continue;
+			char data[4096];
+			ssize_t size = recv(fd, data, sizeof (data), 0);
+			if (size <= 0) break;
+			buffer.append(data, size);
+		}
+		close(fd);
+	}
+
+	void Run()
+	{
+		while (!_Stop) {
+			pollfd pfd = { _ListenFd, POLLIN, 0 };
+			if (poll(&pfd, 1, 10) <= 0) continue;
+			int fd = accept(_ListenFd, NULL, NULL);
+			if (fd < 0) continue;
+			Accepted++;
+			Serve(fd);
+		}
+	}
+
+public:
+	std::atomic<int> Accepted;
+	std::atomic<bool> CloseIdle;		// Close the connection once it is idle.
+	std::atomic<bool> DropNextRequest;	// Close the connection when the next request comes.
+
+	LocalServer() : _ListenFd(-1), _Port(0), _Stop(false), Accepted(0), CloseIdle(false), DropNextRequest(false)
+	{
+		_ListenFd = socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof (addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		bind(_ListenFd, (sockaddr*)&addr, sizeof (addr));
+		listen(_ListenFd, 4);
+		socklen_t addrLength = sizeof (addr);
+		getsockname(_ListenFd, (sockaddr*)&addr, &addrLength);
+		_Port = ntohs(addr.sin_port);
+		_Thread = std::thread(&LocalServer::Run, this);
+	}
+
+	~LocalServer()
+	{
+		_Stop = true;
+		_Thread.join();
+		close(_ListenFd);
+	}
+
+	int GetPort() const { return _Port; }
+};
+
+static bool Collect(const byte* data, int dataSize, void* context)
+{
+	((std::string*)context)->append((const char*)data, dataSize);
+	return true;
+}
+
+int main()
+{
+	LocalServer server;
+	ModemSimulator sim;
+	TcpBridge bridge;
+	sim.SetSocketPeer(&bridge);
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+
+	Wio3GHttpClient client(&wio);
+	CHECK(client.SetHost("localhost", server.GetPort()));
+	Wio3GHttpClient::Response response;
+	std::string body;
+
+	// Keep-alive: three requests, one connection.
+	for (int i = 0; i < 3; i++) {
+		body.clear();
+		CHECK(client.Get("/hello", &response, Collect, &body) == 200);
+		CHECK(body == "hello world");
+		CHECK(response.ContentLength == 11);
+	}
+	CHECK(client.GetConnectCount() == 1);
+	CHECK(server.Accepted == 1);
+
+	// Pipelined.
+	CHECK(client.SendRequest("GET", "/hello"));
+	CHECK(client.SendRequest("GET", "/chunked"));
+	CHECK(client.SendRequest("POST", "/echo", (const byte*)"posted", 6, "text/plain"));
+	CHECK(client.GetPendingNum() == 3);
+	body.clear();
+	CHECK(client.ReadResponse(&response, Collect, &body) == 200);
+	CHECK(body == "hello world");
+	body.clear();
+	CHECK(client.ReadResponse(&response, Collect, &body) == 200);
+	CHECK(response.Chunked);
+	CHECK(body == "abcdefgh");
+	body.clear();
+	CHECK(client.ReadResponse(&response, Collect, &body) == 201);
+	CHECK(body == "posted");
+	CHECK(client.GetPendingNum() == 0);
+
+	// A body larger than the receive buffer of the module reads.
+	body.clear();
+	CHECK(client.Get("/big", &response, Collect, &body) == 200);
+	CHECK(body.size() == BIG_SIZE);
+	CHECK(body[BIG_SIZE - 1] == 'a' + (BIG_SIZE - 1) % 26);
+	CHECK(client.GetConnectCount() == 1);
+
+	// The server closes; the next request reconnects.
+	body.clear();
+	CHECK(client.Get("/close", &response, Collect, &body) == 200);
+	CHECK(body == "bye");
+	CHECK(!response.KeepAlive);
+	body.clear();
+	CHECK(client.Get("/hello", &response, Collect, &body) == 200);
+	CHECK(body == "hello world");
+	CHECK(client.GetConnectCount() == 2);
+	CHECK(server.Accepted == 2);
+	CHECK(bridge.GetOpenCount() == 2);
+
+	// The server closes the idle connection. The "closed" URC waits in the UART, and the next request goes on a new connection.
+	server.CloseIdle = true;
+	while (server.CloseIdle) usleep(1000);
+	usleep(20000);
+	body.clear();
+	CHECK(client.Get("/hello", &response, Collect, &body) == 200);
+	CHECK(body == "hello world");
+	CHECK(client.GetConnectCount() == 3);
+	CHECK(server.Accepted == 3);
+	CHECK(client.GetRequestCount() == 10);	// Seen before sending, so not sent twice.
+
+	// The server closes the idle connection as the request comes. It is sent once more on a new connection.
+	server.DropNextRequest = true;
+	body.clear();
+	CHECK(client.Post("/echo", (const byte*)"again", 5, "text/plain", &response, Collect, &body) == 201);
+	CHECK(body == "again");
+	CHECK(client.GetConnectCount() == 4);
+	CHECK(server.Accepted == 4);
+	CHECK(client.GetRequestCount() == 12);	// Sent twice.
+
+	client.Close();
+
+	return HostTest::Result();
+}
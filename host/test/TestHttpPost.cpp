@@ -0,0 +1,63 @@
+// Wio3G::HttpPost with a producer: a full body is posted, and a producer that falls short sends nothing to the server.
+
+#include "HostTest.h"
+#include <string.h>
+#include <string>
+#include <vector>
+
+class Server : public ModemSimulator::HttpServer
+{
+public:
+	std::vector<std::string> Requests;
+	virtual int OnRequest(const char* method, const std::string& url, const std::string& request, std::string* body, int* contentLength)
+	{
+		Requests.push_back(request);
+		*contentLength = 0;
+		return 200;
+	}
+};
+
+struct Producer {
+	int Remain;		// Bytes it produces before returning 0.
+};
+
+static int Produce(byte* data, int dataSize, void* context)
+{
+	Producer* producer = (Producer*)context;
+	int size = dataSize < producer->Remain ? dataSize : producer->Remain;
+	memset(data, 'a', size);
+	producer->Remain -= size;
+
+	return size;
+}
+
+int main()
+{
+	ModemSimulator sim;
+	Server server;
+	sim.SetHttpServer(&server);
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+
+	int responseCode;
+	Producer full = { 1000 };
+	CHECK(wio.HttpPost("http://example.com/full", Produce, &full, 1000, &responseCode));
+	CHECK(responseCode == 200);
+	CHECK(server.Requests.size() == 1);
+	CHECK(server.Requests[0].size() > 1000 && server.Requests[0].compare(server.Requests[0].size() - 1000, 1000, std::string(1000, 'a')) == 0);
+
+	// Short by 400 bytes: nothing is padded, the module gives up the input and the server sees no request.
+	Producer shortProducer = { 600 };
+	unsigned long start = millis();
+	CHECK(!wio.HttpPost("http://example.com/short", Produce, &shortProducer, 1000, &responseCode));
+	CHECK(millis() - start >= 60000 && millis() - start < 66000);
+	delay(5000);
+	CHECK(server.Requests.size() == 1);
+
+	// The module is back in command mode.
+	Producer next = { 10 };
+	CHECK(wio.HttpPost("http://example.com/next", Produce, &next, 10, &responseCode));
+	CHECK(server.Requests.size() == 2);
+
+	return HostTest::Result();
+}
@@ -0,0 +1,106 @@
+// GetReceivedSignalStrength, SocketSend and SocketReceive must not touch the heap.
+// operator new is counted in this executable; allocations of the simulator are left out by wrapping its SerialAPI.
+
+#include "HostTest.h"
+#include <stdlib.h>
+#include <new>
+
+static unsigned long AllocationNum = 0;
+static int UncountedDepth = 0;
+
+void* operator new(size_t size)
+{
+	if (UncountedDepth == 0) AllocationNum++;
+	void* ptr = malloc(size != 0 ? size : 1);
+	if (ptr == NULL) throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+class Uncounted
+{
+public:
+	Uncounted() { UncountedDepth++; }
+	~Uncounted() { UncountedDepth--; }
+};
+
+// Forwards to the simulator with counting suspended, so only the driver is counted.
+class UncountedSerial : public SerialAPI
+{
+private:
+	SerialAPI* _Serial;
+
+public:
+	UncountedSerial(SerialAPI* serial) : _Serial(serial) {}
+	virtual void Begin(int baud) { Uncounted u; _Serial->Begin(baud); }
+	virtual void SetWriteTimeout(unsigned long timeout) { Uncounted u; _Serial->SetWriteTimeout(timeout); }
+	virtual unsigned long GetWriteTimeout() const { Uncounted u; return _Serial->GetWriteTimeout(); }
+	virtual void Write(byte data) { Uncounted u; _Serial->Write(data); }
+	virtual void Write(const byte* data, int dataSize) { Uncounted u; _Serial->Write(data, dataSize); }
+	virtual bool Available() const { Uncounted u; return _Serial->Available(); }
+	virtual byte Read() { Uncounted u; return _Serial->Read(); }
+	virtual int Read(byte* data, int dataSize) { Uncounted u; return _Serial->Read(data, dataSize); }
+	virtual void SetReadBufferSize(int size) { Uncounted u; _Serial->SetReadBufferSize(size); }
+	virtual void GetReceiveStatistics(ReceiveStatistics* statistics) const { Uncounted u; _Serial->GetReceiveStatistics(statistics); }
+};
+
+class EchoPeer : public ModemSimulator::SocketPeer
+{
+public:
+	virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize)
+	{
+		sim->SocketDeliver(connectId, data, dataSize, 50);
+	}
+};
+
+int main()
+{
+	ModemSimulator sim;
+	EchoPeer peer;
+	sim.SetSocketPeer(&peer);
+	UncountedSerial serial(sim.GetSerial());
+	Wio3G wio(&serial);
+
+	CHECK(HostTest::BringUp(&wio));
+	int connectId = wio.SocketOpen("echo.example.com", 7, WIO_TCP);
+	CHECK(connectId == 0);
+
+	static const byte sendData[1000] = { 0 };
+	static byte receiveData[1500];
+
+	unsigned long beginNum = AllocationNum;
+	CHECK(wio.GetReceivedSignalStrength() == -73);
+	CHECK(AllocationNum == beginNum);
+
+	beginNum = AllocationNum;
+	CHECK(wio.SocketSend(connectId, sendData, sizeof (sendData)));
+	CHECK(AllocationNum == beginNum);
+
+	delay(100);	// The echo arrives.
+	beginNum = AllocationNum;
+	CHECK(wio.SocketReceive(connectId, receiveData, sizeof (receiveData)) == (int)sizeof (sendData));
+	CHECK(AllocationNum == beginNum);
+
+	beginNum = AllocationNum;
+	CHECK(wio.SocketReceive(connectId, receiveData, sizeof (receiveData)) == 0);
+	CHECK(AllocationNum == beginNum);
+
+	// The counter sees allocations outside the simulator.
+	beginNum = AllocationNum;
+	int* volatile probe = new int(0);
+	delete probe;
+	CHECK(AllocationNum == beginNum + 1);
+
+	CHECK(wio.SocketClose(connectId));
+
+	return HostTest::Result();
+}
@@ -0,0 +1,188 @@
+// Wio3GRecordQueue: both drop policies, records kept or discarded by Begin on the same storage, batched Pop,
+// and draining the queue in batches over UDP once the link is up.
+
+#include "HostTest.h"
+#include "Wio3GRecordQueue.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define STORAGE_SIZE	(512)
+#define RECORD_SIZE		(14)
+#define BATCH_NUM		(4)
+
+class Collector : public ModemSimulator::SocketPeer
+{
+public:
+	std::vector<std::string> Datagrams;
+	virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize)
+	{
+		Datagrams.push_back(std::string((const char*)data, dataSize));
+	}
+};
+
+static uint32_t Storage[STORAGE_SIZE / 4];
+
+static std::string Record(int number)
+{
+	char str[RECORD_SIZE + 1];
+	snprintf(str, sizeof (str), "record %d", number);
+
+	return str;
+}
+
+static bool PushRecord(Wio3GRecordQueue* queue, int number)
+{
+	std::string record = Record(number);
+
+	return queue->Push((const byte*)record.data(), record.size());
+}
+
+static std::string PeekRecord(Wio3GRecordQueue* queue, int index)
+{
+	int dataSize;
+	const byte* data = queue->Peek(index, &dataSize);
+	if (data == NULL) return "";
+
+	return std::string((const char*)data, dataSize);
+}
+
+static void TestDropOldest()
+{
+	memset(Storage, 0, sizeof (Storage));
+	Wio3GRecordQueue queue;
+	CHECK(queue.Begin(Storage, sizeof (Storage), RECORD_SIZE, Wio3GRecordQueue::DROP_OLDEST));
+	int capacity = queue.Capacity();
+	CHECK(capacity > BATCH_NUM);
+
+	for (int i = 0; i < capacity + 3; i++) CHECK(PushRecord(&queue, i));
+	CHECK(queue.IsFull());
+	CHECK(queue.Size() == capacity);
+	CHECK(PeekRecord(&queue, 0) == Record(3));
+	CHECK(PeekRecord(&queue, capacity - 1) == Record(capacity + 2));
+
+	Wio3GRecordQueue::Statistics stat;
+	queue.GetStatistics(&stat);
+	CHECK(stat.Pushed == (unsigned long)capacity + 3);
+	CHECK(stat.Dropped == 3);
+	CHECK(stat.HighWater == (unsigned long)capacity);
+}
+
+static void TestDropNewest()
+{
+	memset(Storage, 0, sizeof (Storage));
+	Wio3GRecordQueue queue;
+	CHECK(queue.Begin(Storage, sizeof (Storage), RECORD_SIZE, Wio3GRecordQueue::DROP_NEWEST));
+	int capacity = queue.Capacity();
+
+	for (int i = 0; i < capacity; i++) CHECK(PushRecord(&queue, i));
+	for (int i = capacity; i < capacity + 3; i++) CHECK(!PushRecord(&queue, i));
+	CHECK(queue.Size() == capacity);
+	CHECK(PeekRecord(&queue, 0) == Record(0));
+	CHECK(PeekRecord(&queue, capacity - 1) == Record(capacity - 1));
+
+	Wio3GRecordQueue::Statistics stat;
+	queue.GetStatistics(&stat);
+	CHECK(stat.Pushed == (unsigned long)capacity);
+	CHECK(stat.Dropped == 3);
+
+	// Too long for a record.
+	byte data[RECORD_SIZE + 1] = { 0 };
+	CHECK(queue.Pop(1) == 1);
+	CHECK(!queue.Push(data, sizeof (data)));
+}
+
+static void TestBeginAndPop()
+{
+	memset(Storage, 0, sizeof (Storage));
+	Wio3GRecordQueue queue;
+	CHECK(queue.Begin(Storage, sizeof (Storage), RECORD_SIZE));
+	int capacity = queue.Capacity();
+
+	// Wrap around the end of the ring.
+	for (int i = 0; i < capacity - 2; i++) CHECK(PushRecord(&queue, i));
+	CHECK(queue.Pop(capacity - 4) == capacity - 4);
+	for (int i = capacity - 2; i < capacity + 3; i++) CHECK(PushRecord(&queue, i));
+	CHECK(queue.Size() == 7);
+
+	// After a reset, the same layout finds the records.
+	Wio3GRecordQueue again;
+	CHECK(again.Begin(Storage, sizeof (Storage), RECORD_SIZE));
+	CHECK(again.Size() == 7);
+	CHECK(PeekRecord(&again, 0) == Record(capacity - 4));
+	CHECK(PeekRecord(&again, 6) == Record(capacity + 2));
+
+	// Batched Pop, then one larger than what is left.
+	CHECK(again.Pop(BATCH_NUM) == BATCH_NUM);
+	CHECK(PeekRecord(&again, 0) == Record(capacity - 4 + BATCH_NUM));
+	CHECK(again.Pop(100) == 7 - BATCH_NUM);
+	CHECK(again.IsEmpty());
+	CHECK(again.Pop(1) == 0);
+	CHECK(PeekRecord(&again, 0) == "");
+
+	Wio3GRecordQueue::Statistics stat;
+	again.GetStatistics(&stat);
+	CHECK(stat.Popped == (unsigned long)capacity - 4 + 7);
+
+	// A different layout starts over.
+	CHECK(PushRecord(&again, 0));
+	Wio3GRecordQueue other;
+	CHECK(other.Begin(Storage, sizeof (Storage), RECORD_SIZE * 2));
+	CHECK(other.Capacity() < capacity);
+	CHECK(other.IsEmpty());
+	other.GetStatistics(&stat);
+	CHECK(stat.Pushed == 0);
+
+	// Storage that cannot hold a record.
+	CHECK(!other.Begin(Storage, 16, RECORD_SIZE));
+	CHECK(!other.Begin((byte*)Storage + 1, sizeof (Storage) - 4, RECORD_SIZE));
+}
+
+// Records queued while the link is down are sent in batches once the socket is open. A batch is popped only after it was sent.
+static void TestDrain()
+{
+	ModemSimulator sim;
+	Collector collector;
+	sim.SetSocketPeer(&collector);
+	Wio3G wio(sim.GetSerial());
+
+	memset(Storage, 0, sizeof (Storage));
+	Wio3GRecordQueue queue;
+	CHECK(queue.Begin(Storage, sizeof (Storage), RECORD_SIZE));
+	int num = queue.Capacity() - 1;
+	for (int i = 0; i < num; i++) CHECK(PushRecord(&queue, i));
+
+	CHECK(HostTest::BringUp(&wio));
+	int connectId = wio.SocketOpen("harvest.soracom.io", 8514, WIO_UDP);
+	CHECK(connectId >= 0);
+
+	int batchNum = 0;
+	while (!queue.IsEmpty()) {
+		int sent = 0;
+		for (; sent < BATCH_NUM && sent < queue.Size(); sent++) {
+			int dataSize;
+			const byte* data = queue.Peek(sent, &dataSize);
+			if (!wio.SocketSend(connectId, data, dataSize)) break;
+		}
+		CHECK(sent > 0);
+		if (sent <= 0) break;
+		queue.Pop(sent);
+		batchNum++;
+	}
+	CHECK(wio.SocketClose(connectId));
+
+	CHECK(batchNum == (num + BATCH_NUM - 1) / BATCH_NUM);
+	CHECK(collector.Datagrams.size() == (size_t)num);
+	for (int i = 0; i < num && i < (int)collector.Datagrams.size(); i++) CHECK(collector.Datagrams[i] == Record(i));
+}
+
+int main()
+{
+	TestDropOldest();
+	TestDropNewest();
+	TestBeginAndPop();
+	TestDrain();
+
+	return HostTest::Result();
+}
@@ -0,0 +1,91 @@
+// ResponsePattern must accept exactly the lines slre_match accepts, for every pattern the library waits for.
+
+#include "HostTest.h"
+#include "Internal/ResponsePattern.h"
+#include "Internal/slre.901d42c/slre.h"
+#include <string.h>
+#include <string>
+
+// The patterns passed to ReadResponse in src/, with %d of +QIOPEN filled in.
+static const char* const LibraryPatterns[] = {
+	"^(.+)$",
+	"^(OK|ERROR)$",
+	"^(OK|[0-9]+)$",
+	"^(OK|\\+CME ERROR: .*)$",
+	"^(OK|\\+CNUM: .*)$",
+	"^(OK|\\+QISTATE: .*)$",
+	"^>",
+	"^CONNECT$",
+	"^OK$",
+	"^POWERED DOWN$",
+	"^RDY$",
+	"^SEND OK$",
+	"^\\+CSQ: ([0-9]+),[0-9]+$",
+	"^\\+CUSD: [0-9],\"(.*)\",[0-9]+$",
+	"^\\+QHTTPGET: (.*)$",
+	"^\\+QHTTPPOST: (.*)$",
+	"^\\+QHTTPREAD: 0$",
+	"^\\+QIOPEN: 0,([0-9]+)$",
+	"^\\+QIOPEN: 11,([0-9]+)$",
+	"^\\+QIRD: (.*)$",
+	"^\\+QISEND: [0-9]+,[0-9]+,([0-9]+)$",
+	"^\\+QLTS: (.*)$",
+};
+
+// Module output, including near misses of the patterns above.
+static const char* const Lines[] = {
+	"", "OK", "OK ", " OK", "ERROR", "ERRORS", "0", "12345", "1a", "RDY", "RDY\r",
+	"+CME ERROR: 10", "+CME ERROR:", "+CNUM: ,\"08012345678\",129", "+CNUM:",
+	"+QISTATE: 0,\"TCP\",\"1.2.3.4\",80,0,2,1,0,0,\"uart1\"",
+	">", "> ", ">>", "a>", "CONNECT", "CONNECT 115200", "POWERED DOWN", "SEND OK", "SEND FAIL",
+	"+CSQ: 20,99", "+CSQ: 20,", "+CSQ: ,99", "+CSQ: 2a,99",
+	"+CUSD: 0,\"hello\",15", "+CUSD: 0,\"\",15", "+CUSD: 01,\"x\",15", "+CUSD: 0,\"x\",",
+	"+QHTTPGET: 0,200,12", "+QHTTPGET: ", "+QHTTPPOST: 0,200", "+QHTTPREAD: 0", "+QHTTPREAD: 01",
+	"+QIOPEN: 0,0", "+QIOPEN: 0,565", "+QIOPEN: 1,0", "+QIOPEN: 11,0", "+QIOPEN: 0,",
+	"+QIRD: 1500", "+QIRD: 0", "+QIRD:", "+QISEND: 10,5,5", "+QISEND: 10,5,", "+QISEND: 10,5,5,1",
+	"+QLTS: \"2026/10/17,03:04:05+36,0\"", "+QIURC: \"recv\",0", "+CGREG: 1,\"1A2B\",\"01C3D4E5\",2",
+};
+
+static bool SlreAccepts(const char* pattern, const char* line)
+{
+	return slre_match(pattern, line, strlen(line), NULL, 0, 0) >= 0;
+}
+
+int main()
+{
+	for (unsigned i = 0; i < sizeof (LibraryPatterns) / sizeof (LibraryPatterns[0]); i++) {
+		const char* pattern = LibraryPatterns[i];
+		ResponsePattern compiled(pattern);
+		if (!CHECK(compiled.IsValid())) printf("  %s\n", pattern);
+
+		for (unsigned j = 0; j < sizeof (Lines) / sizeof (Lines[0]); j++) {
+			const char* line = Lines[j];
+			if (!CHECK(compiled.Match(line, strlen(line)) == SlreAccepts(pattern, line))) printf("  %s / \"%s\"\n", pattern, line);
+
+			// The incremental form used by ReadResponseInternal for patterns without $.
+			if (compiled.IsEndAnchored()) continue;
+			bool prefixMatched = false;
+			ResponsePattern::State state = compiled.Begin();
+			for (int k = 0; line[k] != '\0' && !prefixMatched; k++) {
+				state = compiled.Step(state, line[k]);
+				prefixMatched = compiled.IsAccepted(state);
+			}
+			CHECK(prefixMatched == (line[0] != '\0' && SlreAccepts(pattern, line)));
+		}
+	}
+
+	// Escapes SLRE rejects.
+	static const char* const invalidPatterns[] = { "^\\D$", "^\\q", "^\\x4$", "^\\xZZ$", "^a\\", "^[\\D]$" };
+	for (unsigned i = 0; i < sizeof (invalidPatterns) / sizeof (invalidPatterns[0]); i++) {
+		CHECK(!ResponsePattern(invalidPatterns[i]).IsValid());
+	}
+	CHECK(slre_match("^\\D$", "D", 1, NULL, 0, 0) == SLRE_INVALID_METACHARACTER);
+	CHECK(slre_match("^\\q", "q", 1, NULL, 0, 0) == SLRE_INVALID_METACHARACTER);
+	CHECK(slre_match("^\\xZZ$", "Z", 1, NULL, 0, 0) == SLRE_INVALID_METACHARACTER);
+
+	// Escapes both accept.
+	CHECK(ResponsePattern("^\\+\\.\\x41\\t$").Match("+.A\t", 4));
+	CHECK(SlreAccepts("^\\+\\.\\x41\\t$", "+.A\t"));
+
+	return HostTest::Result();
+}
@@ -0,0 +1,86 @@
+// ReplaySerial: a session recorded with Wio3GSerialTrace against the simulator, played back through Wio3G without it.
+
+#include "HostTest.h"
+#include "ReplaySerial.h"
+#include "Wio3GSerialTrace.h"
+#include <string.h>
+#include <string>
+
+class EchoPeer : public ModemSimulator::SocketPeer
+{
+public:
+	virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize)
+	{
+		sim->SocketDeliver(connectId, data, dataSize, 50);
+	}
+};
+
+class StringPrint : public Print
+{
+public:
+	std::string Text;
+	virtual size_t write(uint8_t data) { Text.push_back(data); return 1; }
+};
+
+static void Session(Wio3G* wio)
+{
+	CHECK(wio->GetReceivedSignalStrength() == -113 + 2 * 20);
+	int connectId = wio->SocketOpen("echo.example.com", 7, WIO_TCP);
+	CHECK(connectId == 0);
+	CHECK(wio->SocketSend(connectId, "hello"));
+	char data[100];
+	CHECK(wio->SocketReceive(connectId, data, sizeof (data), 1000) == 5);
+	CHECK(strcmp(data, "hello") == 0);
+	CHECK(wio->SocketClose(connectId));
+}
+
+int main()
+{
+	std::string text;
+	unsigned long recordTime;
+	{
+		ModemSimulator sim;
+		EchoPeer peer;
+		sim.SetSocketPeer(&peer);
+
+		Wio3G bringUp(sim.GetSerial());
+		CHECK(HostTest::BringUp(&bringUp));
+
+		// Recorded from a Wio3G just constructed, as the one of the replay is.
+		static byte traceBuffer[16 * 1024];
+		Wio3GSerialTrace trace(sim.GetSerial(), traceBuffer, sizeof (traceBuffer));
+		Wio3G wio(&trace);
+
+		unsigned long start = micros();
+		Session(&wio);
+		recordTime = micros() - start;
+		CHECK(trace.GetDroppedCount() == 0);
+
+		StringPrint dump;
+		trace.Dump(dump);
+		text = dump.Text;
+	}
+
+	// The same calls read the same responses, at about the same times.
+	ReplaySerial replay;
+	CHECK(replay.Load(text.c_str()));
+	Wio3G wio(&replay);
+	unsigned long start = micros();
+	Session(&wio);
+	unsigned long replayTime = micros() - start;
+	CHECK(replay.IsFinished());
+	CHECK(replay.GetMismatchCount() == 0);
+	CHECK(replayTime + 5000 >= recordTime && replayTime <= recordTime + 5000);
+
+	// Other commands than the recorded ones are counted.
+	CHECK(replay.Load(text.c_str()));
+	Wio3G other(&replay);
+	char imei[16];
+	other.GetIMEI(imei, sizeof (imei));
+	CHECK(replay.GetMismatchCount() >= 1);
+
+	CHECK(!replay.Load("12 <> 41"));
+	CHECK(!replay.Load("12 -> 4"));
+
+	return HostTest::Result();
+}
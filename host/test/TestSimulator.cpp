@@ -0,0 +1,86 @@
+// Wio3G(SerialAPI*) against the simulator: boot, attach, a TCP echo and an HTTP GET.
+// Links without Wio3GHardware.cpp, so nothing here touches SerialModule or the STM32.
+
+#include "HostTest.h"
+#include "Wio3GSerialTrace.h"
+#include <string.h>
+#include <string>
+
+class EchoPeer : public ModemSimulator::SocketPeer
+{
+public:
+	virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize)
+	{
+		sim->SocketDeliver(connectId, data, dataSize, 50);
+	}
+};
+
+class Server : public ModemSimulator::HttpServer
+{
+public:
+	virtual int OnRequest(const char* method, const std::string& url, const std::string& request, std::string* body, int* contentLength)
+	{
+		*body = std::string(method) + " " + url;
+		*contentLength = body->size();
+		return 200;
+	}
+};
+
+class StringPrint : public Print
+{
+public:
+	std::string Text;
+	virtual size_t write(uint8_t data) { Text.push_back(data); return 1; }
+};
+
+int main()
+{
+	ModemSimulator sim;
+	EchoPeer peer;
+	Server server;
+	sim.SetSocketPeer(&peer);
+	sim.SetHttpServer(&server);
+
+	static byte traceBuffer[16 * 1024];
+	Wio3GSerialTrace trace(sim.GetSerial(), traceBuffer, sizeof (traceBuffer));
+	Wio3G wio(&trace);
+
+	CHECK(HostTest::BringUp(&wio));
+	CHECK(sim.IsRunning());
+
+	char imei[16];
+	CHECK(wio.GetIMEI(imei, sizeof (imei)) == 15);
+	CHECK(strcmp(imei, "865473030000001") == 0);
+	CHECK(wio.GetReceivedSignalStrength() == -113 + 2 * 20);
+
+	Wio3G::RegistrationStatus registration;
+	wio.GetPSRegistration(&registration);
+	CHECK(registration.Status == 1);
+	CHECK(registration.LocationAreaCode == 0x1A2B);
+
+	int connectId = wio.SocketOpen("echo.example.com", 7, WIO_TCP);
+	CHECK(connectId == 0);
+	CHECK(sim.IsSocketOpen(0));
+	CHECK(wio.SocketSend(connectId, "hello"));
+	char data[100];
+	CHECK(wio.SocketReceive(connectId, data, sizeof (data), 1000) == 5);
+	CHECK(strcmp(data, "hello") == 0);
+	CHECK(wio.SocketReceive(connectId, data, sizeof (data)) == 0);
+	CHECK(wio.SocketSend(connectId, "x"));
+	CHECK(wio.SocketReceive(connectId, data, 1) == 0 && data[0] == '\0');	// Room for the terminator only.
+	CHECK(wio.SocketReceive(connectId, data, 1, 1000) == 0 && data[0] == '\0');
+	CHECK(wio.SocketReceive(connectId, data, sizeof (data), 1000) == 1 && data[0] == 'x');
+	CHECK(wio.SocketClose(connectId));
+	CHECK(!sim.IsSocketOpen(0));
+
+	char body[100];
+	CHECK(wio.HttpGet("http://example.com/a", body, sizeof (body)) == 24);
+	CHECK(strcmp(body, "GET http://example.com/a") == 0);
+
+	StringPrint dump;
+	trace.Dump(dump);
+	CHECK(dump.Text.find(" <- 41542B514953454E443D302C35") != std::string::npos);	// AT+QISEND=0,5
+	CHECK(dump.Text.find(" -> 0D0A53454E44204F4B0D0A") != std::string::npos);	// SEND OK
+
+	return HostTest::Result();
+}
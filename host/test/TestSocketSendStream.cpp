@@ -0,0 +1,84 @@
+// SocketSendStream against a peer that acknowledges late: every byte arrives in order, the unacknowledged
+// bytes never exceed the window, and the window is only queried when it looks full.
+
+#include "HostTest.h"
+#include <string.h>
+#include <string>
+
+#define SEGMENT_SIZE	(1460)
+#define WINDOW_SIZE		(SEGMENT_SIZE * 4)
+#define DATA_SIZE		(50000)
+
+class Sink : public ModemSimulator::SocketPeer
+{
+public:
+	std::string Received;
+	unsigned long MaxUnacked;
+
+	Sink() : MaxUnacked(0) {}
+	virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize)
+	{
+		Received.append((const char*)data, dataSize);
+		unsigned long unacked = sim->GetSocketSentBytes(connectId) - sim->GetSocketAckedBytes(connectId);
+		if (unacked > MaxUnacked) MaxUnacked = unacked;
+	}
+};
+
+static byte Data[DATA_SIZE];
+
+static int Produce(byte* data, int dataSize, void* context)
+{
+	int* offset = (int*)context;
+	int size = DATA_SIZE - *offset < 1000 ? DATA_SIZE - *offset : 1000;	// Smaller than a segment.
+	if (size > dataSize) size = dataSize;
+	memcpy(data, &Data[*offset], size);
+	*offset += size;
+
+	return size;
+}
+
+static void SendWithAckDelay(unsigned long ackDelay, bool producer)
+{
+	ModemSimulator sim;
+	ModemSimulator::Timing timing = sim.GetTiming();
+	timing.SendAckDelay = ackDelay;
+	sim.SetTiming(timing);
+	Sink sink;
+	sim.SetSocketPeer(&sink);
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+	int connectId = wio.SocketOpen("example.com", 9, WIO_TCP);
+	CHECK(connectId == 0);
+
+	Wio3G::SocketSendStatistics statistics;
+	int offset = 0;
+	int sentSize = producer ? wio.SocketSendStream(connectId, Produce, &offset, &statistics) : wio.SocketSendStream(connectId, Data, DATA_SIZE, &statistics);
+	CHECK(sentSize == DATA_SIZE);
+	CHECK(sink.Received.size() == DATA_SIZE && memcmp(sink.Received.data(), Data, DATA_SIZE) == 0);
+	CHECK(statistics.Bytes == DATA_SIZE);
+	CHECK(statistics.Segments == (DATA_SIZE + SEGMENT_SIZE - 1) / SEGMENT_SIZE);
+	CHECK(sink.MaxUnacked <= WINDOW_SIZE);
+
+	// Four segments go out per acknowledgement delay, not one.
+	unsigned long windows = (statistics.Segments + 3) / 4;
+	if (ackDelay >= 500) {
+		CHECK(statistics.WindowQueries >= windows - 1);
+		CHECK(statistics.ElapsedTime >= (windows - 1) * ackDelay);
+		CHECK(statistics.ElapsedTime < statistics.Segments * ackDelay / 2);
+	}
+	printf("ack delay %lu ms%s: %lu bytes/s, %lu window queries\n", ackDelay, producer ? " (producer)" : "", statistics.BytesPerSecond, statistics.WindowQueries);
+
+	CHECK(wio.SocketClose(connectId));
+}
+
+int main()
+{
+	for (int i = 0; i < DATA_SIZE; i++) Data[i] = (byte)(i * 7 + i / 251);
+
+	SendWithAckDelay(100, false);
+	SendWithAckDelay(500, false);
+	SendWithAckDelay(2000, false);
+	SendWithAckDelay(2000, true);
+
+	return HostTest::Result();
+}
@@ -0,0 +1,83 @@
+// Wio3GUdpSession: datagrams up to the AT+QISEND limit, and a datagram the module refuses neither blocks the queue nor Poll().
+
+#include "HostTest.h"
+#include "Wio3GUdpSession.h"
+#include <string>
+#include <vector>
+
+class Collector : public ModemSimulator::SocketPeer
+{
+public:
+	std::vector<std::string> Datagrams;
+	virtual void OnSend(ModemSimulator* sim, int connectId, const byte* data, int dataSize)
+	{
+		Datagrams.push_back(std::string((const char*)data, dataSize));
+	}
+};
+
+// The module answers ERROR to any QISEND of 13 bytes.
+static bool RefuseSize13(ModemSimulator* sim, const std::string& command, void* context)
+{
+	if (command.compare(0, 10, "AT+QISEND=") != 0 || command.compare(command.size() - 3, 3, ",13") != 0) return false;
+	sim->Reply("\r\nERROR\r\n");
+	return true;
+}
+
+// The module never answers AT+QISEND=<id>,<length>.
+static bool IgnoreQisend(ModemSimulator* sim, const std::string& command, void* context)
+{
+	return command.compare(0, 10, "AT+QISEND=") == 0 && command.find(',') != std::string::npos;
+}
+
+int main()
+{
+	ModemSimulator sim;
+	Collector collector;
+	sim.SetSocketPeer(&collector);
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+
+	Wio3GUdpSession session(&wio);
+	CHECK(session.Begin("harvest.soracom.io", 8514));
+
+	static byte data[1461];
+	for (int i = 0; i < (int)sizeof (data); i++) data[i] = (byte)i;
+	CHECK(!session.Send(data, 1461));
+	CHECK(session.GetDroppedCount() == 0);
+	CHECK(session.Send(data, 1460));
+	CHECK(session.GetSentCount() == 1);
+	CHECK(collector.Datagrams.size() == 1 && collector.Datagrams[0].size() == 1460);
+
+	sim.SetCommandHandler(RefuseSize13, NULL);
+	CHECK(session.Send("thirteen-byte"));	// Queued, refused.
+	CHECK(session.GetQueuedNum() == 1);
+	CHECK(session.Send("next"));			// Behind the refused one.
+	CHECK(session.GetQueuedNum() == 2);
+	session.Poll();							// Third attempt, dropped.
+	CHECK(session.GetQueuedNum() == 1);
+	CHECK(session.GetDroppedCount() == 1);
+	session.Poll();
+	CHECK(session.GetQueuedNum() == 0);
+	CHECK(session.GetSentCount() == 2);
+	CHECK(collector.Datagrams.back() == "next");
+	CHECK(session.IsOpen());
+
+	// With no prompt at all, each Poll() waits for one prompt timeout, not one per attempt or per datagram.
+	sim.SetCommandHandler(IgnoreQisend, NULL);
+	for (int i = 0; i < 3; i++) CHECK(session.Send("queued"));
+	for (int i = 0; i < 3; i++) {
+		unsigned long start = millis();
+		session.Poll();
+		CHECK(millis() - start < 1000);
+	}
+	CHECK(session.GetDroppedCount() == 1 + 2);	// Each Send() tried the first once too.
+	CHECK(session.GetQueuedNum() == 1);
+	sim.SetCommandHandler(NULL, NULL);
+	session.Poll();
+	CHECK(session.GetQueuedNum() == 0);
+	CHECK(session.GetSentCount() == 3);
+
+	session.End();
+
+	return HostTest::Result();
+}
@@ -0,0 +1,69 @@
+// Wio3GClient send coalescing: data waits for more until the idle timeout, and goes out on the next call after it.
+// Received data is read after a lost "recv" URC too, and a failed send closes the connection.
+
+#include "HostTest.h"
+#include "Wio3GClient.h"
+#include <string.h>
+
+static bool RefuseQisend(ModemSimulator* sim, const std::string& command, void* context)
+{
+	if (command.compare(0, 10, "AT+QISEND=") != 0) return false;
+	sim->Reply("\r\nERROR\r\n");
+	return true;
+}
+
+int main()
+{
+	ModemSimulator sim;
+	Wio3G wio(sim.GetSerial());
+	CHECK(HostTest::BringUp(&wio));
+
+	Wio3GClient client(&wio);
+	client.SetSendIdleTimeout(20);
+	CHECK(client.connect("example.com", 80) == 1);
+	int connectId = 0;
+
+	for (int i = 0; i < 10; i++) CHECK(client.write('a' + i) == 1);
+	CHECK(sim.GetSocketSentBytes(connectId) == 0);
+
+	// connected() alone sends it after the timeout, as in a PubSubClient::loop() without traffic.
+	delay(10);
+	CHECK(client.connected());
+	CHECK(sim.GetSocketSentBytes(connectId) == 0);
+	delay(20);
+	CHECK(client.connected());
+	CHECK(sim.GetSocketSentBytes(connectId) == 10);
+	CHECK(client.GetSendCount() == 1);
+
+	CHECK(client.write((const uint8_t*)"xyz", 3) == 3);
+	client.flush();
+	CHECK(sim.GetSocketSentBytes(connectId) == 13);
+	CHECK(client.GetSendCount() == 2);
+	CHECK(client.GetSentBytes() == 13);
+
+	// Data whose "recv" URC was lost is still read, by the fallback AT+QIRD.
+	CHECK(client.available() == 0);
+	sim.SetRecvUrcLost(true);
+	sim.SocketDeliver(connectId, "lost", 10);
+	unsigned long start = millis();
+	while (client.available() == 0 && millis() - start < 3000) delay(10);
+	CHECK(millis() - start <= 1000 + 100);
+	char data[10];
+	CHECK(client.read((uint8_t*)data, sizeof (data)) == 4 && memcmp(data, "lost", 4) == 0);
+	sim.SetRecvUrcLost(false);
+
+	client.stop();
+	CHECK(!client.connected());
+
+	// A failed send of written data closes the connection, so the loss shows in connected().
+	CHECK(client.connect("example.com", 80) == 1);
+	CHECK(client.write((const uint8_t*)"abc", 3) == 3);
+	sim.SetCommandHandler(RefuseQisend, NULL);
+	delay(30);
+	CHECK(!client.connected());
+	CHECK(!sim.IsSocketOpen(connectId));
+	CHECK(client.write((const uint8_t*)"def", 3) == 0);
+	sim.SetCommandHandler(NULL, NULL);
+
+	return HostTest::Result();
+}
@@ -7,13 +7,17 @@
 #include <string.h>
 
 #define READ_BYTE_TIMEOUT	(10)
-#define RESPONSE_MAX_LENGTH	(1024)
+#define BINARY_CHUNK_SIZE	(256)
+#define TERMINATOR_MAX_LENGTH	(8)
 
 #define CHAR_CR (0x0d)
 #define CHAR_LF (0x0a)
 
-AtSerial::AtSerial(SerialAPI* serial, Wio3G* wio3G) : _Serial(serial), _Wio3G(wio3G), _EchoOn(true)
+AtSerial::AtSerial(SerialAPI* serial, Wio3G* wio3G) : _Serial(serial), _Wio3G(wio3G), _EchoOn(true), _ResponseLength(0), _PartialLength(0), _IdleHook(NULL), _IdleContext(NULL)
 {
+	_Response[0] = '\0';
+	memset(&_CommandWait, 0, sizeof(_CommandWait));
+	memset(&_TotalWait, 0, sizeof(_TotalWait));
 }
 
 void AtSerial::SetEcho(bool on)
@@ -21,35 +25,70 @@ void AtSerial::SetEcho(bool on)
 	_EchoOn = on;
 }
 
+// hook is NULL to busy-wait.
+void AtSerial::SetIdleHook(IdleHook hook, void* context)
+{
+	_IdleHook = hook;
+	_IdleContext = context;
+}
+
+void AtSerial::GetWaitStatistics(WaitStatistics* command, WaitStatistics* total) const
+{
+	if (command != NULL) *command = _CommandWait;
+	if (total != NULL) *total = _TotalWait;
+}
+
 bool AtSerial::WaitForAvailable(Stopwatch* sw, unsigned long timeout) const
 {
+	if (_Serial->Available()) return true;
+
+	bool available = true;
+	unsigned long iterations = 0;
+	unsigned long idleMicros = 0;
+	unsigned long beginTime = micros();
 	while (!_Serial->Available()) {
 		if (timeout >= 0 && sw != NULL && sw->ElapsedMilliseconds() >= timeout) {
 			DEBUG_PRINTLN("### TIMEOUT ###");
-			return false;
+			available = false;
+			break;
+		}
+
+		if (_IdleHook != NULL) {
+			unsigned long idleTime = micros();
+			_IdleHook(_IdleContext);
+			idleMicros += micros() - idleTime;
 		}
+		iterations++;
 	}
+	unsigned long waitMicros = micros() - beginTime;
 
-	return true;
+	_CommandWait.Iterations += iterations;
+	_CommandWait.WaitMicros += waitMicros;
+	_CommandWait.IdleMicros += idleMicros;
+	_TotalWait.Iterations += iterations;
+	_TotalWait.WaitMicros += waitMicros;
+	_TotalWait.IdleMicros += idleMicros;
+
+	return available;
 }
 
 void AtSerial::WriteBinary(const byte* data, int dataSize)
 {
 	DEBUG_PRINTLN("<- (binary)");
 
-	for (int i = 0; i < dataSize; i++) {
-		_Serial->Write(data[i]);
-	}
+	AT_STATISTICS_BEGIN("(binary)");	// Ends at SEND OK, SEND FAIL or OK.
+	_Serial->Write(data, dataSize);
 }
 
 bool AtSerial::ReadBinary(byte* data, int dataSize, unsigned long timeout)
 {
 	Stopwatch sw;
-	for (int i = 0; i < dataSize; i++) {
+	int i = 0;
+	while (i < dataSize) {
 		sw.Restart();
 		if (!WaitForAvailable(&sw, timeout)) return false;
 
-		data[i] = _Serial->Read();
+		i += _Serial->Read(&data[i], dataSize - i);
 	}
 
 	DEBUG_PRINTLN("-> (binary)");
@@ -57,48 +96,137 @@ bool AtSerial::ReadBinary(byte* data, int dataSize, unsigned long timeout)
 	return true;
 }
 
+// Read dataSize bytes and pass them to the consumer in chunks of up to BINARY_CHUNK_SIZE bytes.
+// Returns false on timeout. *stopped is set if the consumer returned false.
+bool AtSerial::ReadBinary(int dataSize, BinaryConsumer consumer, void* context, unsigned long timeout, bool* stopped)
+{
+	byte chunk[BINARY_CHUNK_SIZE];
+	bool consuming = true;
+
+	while (dataSize > 0) {
+		int chunkSize = dataSize < BINARY_CHUNK_SIZE ? dataSize : BINARY_CHUNK_SIZE;
+		if (!ReadBinary(chunk, chunkSize, timeout)) return false;
+		if (consuming) consuming = consumer(chunk, chunkSize, context);
+		dataSize -= chunkSize;
+	}
+
+	*stopped = !consuming;
+
+	return true;
+}
+
+// Read binary data up to and including the terminator, passing the data before it to the consumer in chunks.
+// The terminator is searched as the bytes arrive (KMP), and only the bytes that may still be part of it are held back.
+// Returns the number of bytes before the terminator, or -1 on timeout. *stopped is set if the consumer returned false.
+int AtSerial::ReadBinaryUntil(const char* terminator, BinaryConsumer consumer, void* context, unsigned long timeout, bool* stopped)
+{
+	int terminatorLength = strlen(terminator);
+	if (terminatorLength <= 0 || TERMINATOR_MAX_LENGTH < terminatorLength) return -1;
+
+	// failure[i] is the length of the longest proper border of terminator[0..i].
+	int failure[TERMINATOR_MAX_LENGTH];
+	failure[0] = 0;
+	for (int i = 1, k = 0; i < terminatorLength; i++) {
+		while (k > 0 && terminator[i] != terminator[k]) k = failure[k - 1];
+		if (terminator[i] == terminator[k]) k++;
+		failure[i] = k;
+	}
+
+	byte chunk[BINARY_CHUNK_SIZE];
+	int chunkSize = 0;
+	int dataLength = 0;
+	bool consuming = true;
+	int matched = 0;
+
+	// Read one byte at a time so nothing after the terminator is consumed.
+	Stopwatch sw;
+	while (matched < terminatorLength) {
+		sw.Restart();
+		if (!WaitForAvailable(&sw, timeout)) return -1;
+		char c = _Serial->Read();
+
+		int next = matched;
+		while (next > 0 && c != terminator[next]) next = failure[next - 1];
+		if (c == terminator[next]) next++;
+
+		// The held back bytes terminator[0..matched) plus c. Everything except the last next bytes is data.
+		int releaseLength = matched + 1 - next;
+		for (int i = 0; i < releaseLength; i++) {
+			chunk[chunkSize++] = i < matched ? terminator[i] : c;
+			if (chunkSize >= BINARY_CHUNK_SIZE) {
+				if (consuming) consuming = consumer(chunk, chunkSize, context);
+				dataLength += chunkSize;
+				chunkSize = 0;
+			}
+		}
+		matched = next;
+	}
+	if (chunkSize >= 1) {
+		if (consuming) consuming = consumer(chunk, chunkSize, context);
+		dataLength += chunkSize;
+	}
+
+	DEBUG_PRINTLN("-> (binary)");
+
+	*stopped = !consuming;
+
+	return dataLength;
+}
+
 void AtSerial::WriteCommand(const char* command)
 {
 	DEBUG_PRINT("<- ");
 	DEBUG_PRINTLN(command);
 
-	while (*command != '\0') {
-		_Serial->Write((byte)*command);
-		command++;
-	}
+	AT_STATISTICS_BEGIN(command);
+	memset(&_CommandWait, 0, sizeof(_CommandWait));
+	_Serial->Write((const byte*)command, strlen(command));
 	_Serial->Write((byte)CHAR_CR);
 }
 
-bool AtSerial::ReadResponseInternal(const char* pattern, unsigned long timeout, std::string* response, int responseMaxLength)
+bool AtSerial::ReadResponseInternal(const ResponsePattern* pattern, unsigned long timeout, char* response, int responseMaxLength, int* responseLength)
 {
 	DEBUG_PRINT("-> ");
 
-	response->clear();
+	// *responseLength bytes of the line may already have been read.
+	int length = *responseLength;
+
+	ResponsePattern::State state = pattern != NULL ? pattern->Begin() : 0;
+	if (pattern != NULL) {
+		for (int i = 0; i < length; i++) state = pattern->Step(state, response[i]);
+	}
 
 	Stopwatch sw;
 	while (true) {
-		if (response->size() >= (size_t)(responseMaxLength + 2)) {
+		if (length >= responseMaxLength + 2) {
 			DEBUG_PRINTLN("### OVERFLOW ###");
+			AT_STATISTICS_OVERFLOW();
 			return false;
 		}
 
 		sw.Restart();
 		if (!WaitForAvailable(&sw, timeout)) {
 			DEBUG_PRINTLN("### TIMEOUT ###");
+			AT_STATISTICS_TIMEOUT();
 			return false;
 		}
 
-		response->push_back(_Serial->Read());
+		char ch = _Serial->Read();
+		response[length++] = ch;
 
-		if (response->size() >= 2 && response->at(response->size() - 2) == CHAR_CR && response->at(response->size() - 1) == CHAR_LF) {
-			response->resize(response->size() - 2);
-			DEBUG_PRINTLN(response->c_str());
+		if (length >= 2 && response[length - 2] == CHAR_CR && response[length - 1] == CHAR_LF) {
+			response[length] = '\0';
+			DEBUG_PRINT(response);
+			*responseLength = length - 2;
 			return true;
 		}
 
 		if (pattern != NULL) {
-			if (slre_match(pattern, response->c_str(), response->size(), NULL, 0, 0) >= 1) {
-				DEBUG_PRINTLN(response->c_str());
+			state = pattern->Step(state, ch);
+			if (pattern->IsAccepted(state)) {
+				response[length] = '\0';
+				DEBUG_PRINTLN(response);
+				*responseLength = length;
 				return true;
 			}
 		}
@@ -107,32 +235,70 @@ bool AtSerial::ReadResponseInternal(const char* pattern, unsigned long timeout,
 
 bool AtSerial::ReadResponse(const char* pattern, unsigned long timeout, std::string* capture)
 {
-	const char* internalPattern = NULL;
-	if (pattern[strlen(pattern) - 1] != '$') {
-		internalPattern = pattern;
+	ResponsePattern compiledPattern(pattern);
+	return ReadResponse(compiledPattern, timeout, capture);
+}
+
+bool AtSerial::ReadResponse(const ResponsePattern& pattern, unsigned long timeout, std::string* capture)
+{
+	const char* captureStr;
+	int captureLength;
+	if (!ReadResponse(pattern, timeout, capture != NULL ? &captureStr : NULL, &captureLength)) return false;
+
+	if (capture != NULL) capture->assign(captureStr, captureLength);
+
+	return true;
+}
+
+bool AtSerial::ReadResponse(const char* pattern, unsigned long timeout, const char** capture, int* captureLength)
+{
+	ResponsePattern compiledPattern(pattern);
+	return ReadResponse(compiledPattern, timeout, capture, captureLength);
+}
+
+// The capture points into the internal response buffer and is valid until the next read.
+// It is NUL-terminated only when the capture group extends to the end of the line.
+bool AtSerial::ReadResponse(const ResponsePattern& pattern, unsigned long timeout, const char** capture, int* captureLength)
+{
+	if (!pattern.IsValid()) {
+		DEBUG_PRINTLN("### INVALID PATTERN ###");
+		return false;
+	}
+
+	const ResponsePattern* internalPattern = NULL;
+	if (!pattern.IsEndAnchored()) {
+		internalPattern = &pattern;
 	}
 
 	Stopwatch sw;
 	sw.Restart();
 	while (true) {
-		if (!WaitForAvailable(&sw, timeout)) return false;
+		if (!WaitForAvailable(&sw, timeout)) {
+			AT_STATISTICS_TIMEOUT();
+			return false;
+		}
 
-		std::string response;
-		if (!ReadResponseInternal(internalPattern, _EchoOn ? timeout : READ_BYTE_TIMEOUT, &response, RESPONSE_MAX_LENGTH)) return false;
+		_ResponseLength = _PartialLength;
+		_PartialLength = 0;
+		if (!ReadResponseInternal(internalPattern, _EchoOn ? timeout : READ_BYTE_TIMEOUT, _Response, RESPONSE_MAX_LENGTH, &_ResponseLength)) return false;
+		_Response[_ResponseLength] = '\0';
+		AT_STATISTICS_RESPONSE(_Response);
 
-		if (_Wio3G->ReadResponseCallback(response.c_str())) {
+		if (_Wio3G->ReadResponseCallback(_Response)) {
 			continue;
 		}
 
-		slre_cap cap;
-		cap.len = 0;
-		if (slre_match(pattern, response.c_str(), response.size(), &cap, 1, 0) >= 1) {
-			if (capture != NULL) {
-				capture->resize(cap.len);
-				memcpy(&(*capture)[0], cap.ptr, cap.len);
-			}
-			return true;
+		if (!pattern.Match(_Response, _ResponseLength)) continue;
+
+		if (capture != NULL) {
+			slre_cap cap;
+			cap.ptr = NULL;
+			cap.len = 0;
+			if (slre_match(pattern.GetPattern(), _Response, _ResponseLength, &cap, 1, 0) < 0) continue;
+			*capture = cap.ptr != NULL ? cap.ptr : &_Response[_ResponseLength];
+			*captureLength = cap.len;
 		}
+		return true;
 	}
 }
 
@@ -142,6 +308,12 @@ bool AtSerial::WriteCommandAndReadResponse(const char* command, const char* patt
 	return ReadResponse(pattern, timeout, capture);
 }
 
+bool AtSerial::WriteCommandAndReadResponse(const char* command, const ResponsePattern& pattern, unsigned long timeout, std::string* capture)
+{
+	WriteCommand(command);
+	return ReadResponse(pattern, timeout, capture);
+}
+
 bool AtSerial::ReadResponseQHTTPREAD(char* data, int dataSize, unsigned long timeout)
 {
 	int contentLength = 0;
@@ -151,17 +323,73 @@ bool AtSerial::ReadResponseQHTTPREAD(char* data, int dataSize, unsigned long tim
 	while (true) {
 		if (!WaitForAvailable(&sw, timeout)) return false;
 
-		std::string response;
-		if (!ReadResponseInternal(NULL, 1000, &response, dataSize - 2 - 1)) return false;
-		if (response == "OK") break;
+		// Lines are read in place, so the CR/LF between them is kept as is.
+		int responseLength = 0;
+		if (!ReadResponseInternal(NULL, 1000, &data[contentLength], dataSize - contentLength - 2 - 1, &responseLength)) return false;
+		if (responseLength == 2 && strncmp(&data[contentLength], "OK", 2) == 0) break;
 
-		if (contentLength + response.size() + 2 + 1 > (size_t)dataSize) return false;
-		memcpy(&data[contentLength], response.c_str(), response.size());
-		strcpy(&data[contentLength + response.size()], "\r\n");
-		contentLength += response.size() + 2;
+		contentLength += responseLength + 2;
 	}
-	if (contentLength >= 2 && strcmp(&data[contentLength - 2], "\r\n") == 0) contentLength -= 2;
+	if (contentLength >= 2 && strncmp(&data[contentLength - 2], "\r\n", 2) == 0) contentLength -= 2;
 	data[contentLength] = '\0';
 
 	return true;
 }
+
+// Read the bytes that have already arrived without waiting for more.
+// Returns true when a complete line has been assembled. An incomplete line is kept for the next call.
+bool AtSerial::PollResponse(const char** response, int* responseLength)
+{
+	while (_Serial->Available()) {
+		if (_PartialLength >= RESPONSE_MAX_LENGTH + 2) {
+			DEBUG_PRINTLN("-> ### OVERFLOW ###");
+			AT_STATISTICS_OVERFLOW();
+			_PartialLength = 0;
+		}
+
+		_Response[_PartialLength++] = _Serial->Read();
+
+		if (_PartialLength >= 2 && _Response[_PartialLength - 2] == CHAR_CR && _Response[_PartialLength - 1] == CHAR_LF) {
+			_ResponseLength = _PartialLength - 2;
+			_PartialLength = 0;
+			_Response[_ResponseLength] = '\0';
+			DEBUG_PRINT("-> ");
+			DEBUG_PRINTLN(_Response);
+			AT_STATISTICS_RESPONSE(_Response);
+
+			*response = _Response;
+			*responseLength = _ResponseLength;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Read up to dataSize bytes of binary data that have already arrived, without waiting.
+// Call it only between lines, when PollResponse holds no incomplete line.
+int AtSerial::PollBinary(byte* data, int dataSize)
+{
+	if (!_Serial->Available()) return 0;
+
+	return _Serial->Read(data, dataSize);
+}
+
+// Wait for unsolicited result codes and pass every complete line to the callback.
+// Returns false when no complete line arrived within the timeout.
+bool AtSerial::ReadUnsolicitedResponse(unsigned long timeout)
+{
+	Stopwatch sw;
+	sw.Restart();
+	while (true) {
+		bool received = false;
+		const char* response;
+		int responseLength;
+		while (PollResponse(&response, &responseLength)) {
+			_Wio3G->ReadResponseCallback(response);
+			received = true;
+		}
+		if (received) return true;
+		if (!WaitForAvailable(&sw, timeout)) return false;
+	}
+}
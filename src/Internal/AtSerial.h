@@ -2,33 +2,69 @@
 
 #include "SerialAPI.h"
 #include "Stopwatch.h"
+#include "ResponsePattern.h"
+#include "AtStatistics.h"
 #include <string>
 
+#define RESPONSE_MAX_LENGTH	(1024)
+
 class Wio3G;
 
 class AtSerial
 {
+public:
+	// Receive a chunk of binary data. Return false to stop passing data (the rest is still read and discarded).
+	typedef bool (*BinaryConsumer)(const byte* data, int dataSize, void* context);
+
+	// Called repeatedly while waiting for the module. It should return within a few milliseconds.
+	typedef void (*IdleHook)(void* context);
+
+	struct WaitStatistics {
+		unsigned long Iterations;	// Times the idle hook was called.
+		unsigned long WaitMicros;	// Time spent waiting for the module.
+		unsigned long IdleMicros;	// Time spent in the idle hook. WaitMicros - IdleMicros is the estimated active time.
+	};
+
 private:
 	SerialAPI* _Serial;
 	Wio3G* _Wio3G;
 	unsigned long _EchoOn;
+	char _Response[RESPONSE_MAX_LENGTH + 2 + 1];	// Last response line. Reused for every line, never allocated.
+	int _ResponseLength;
+	int _PartialLength;		// Bytes of an incomplete line left in _Response by PollResponse.
+	IdleHook _IdleHook;
+	void* _IdleContext;
+	mutable WaitStatistics _CommandWait;	// Since the last WriteCommand.
+	mutable WaitStatistics _TotalWait;
 
-	bool ReadResponseInternal(const char* pattern, unsigned long timeout, std::string* response, int responseMaxLength);
+	bool ReadResponseInternal(const ResponsePattern* pattern, unsigned long timeout, char* response, int responseMaxLength, int* responseLength);
 
 public:
 	AtSerial(SerialAPI* serial, Wio3G* wio3G);
 
 	void SetEcho(bool on);
+	void SetIdleHook(IdleHook hook, void* context);
+	void GetWaitStatistics(WaitStatistics* command, WaitStatistics* total) const;
 
 	bool WaitForAvailable(Stopwatch* sw, unsigned long timeout) const;
 
 	void WriteBinary(const byte* data, int dataSize);
 	bool ReadBinary(byte* data, int dataSize, unsigned long timeout);
+	bool ReadBinary(int dataSize, BinaryConsumer consumer, void* context, unsigned long timeout, bool* stopped);
+	int ReadBinaryUntil(const char* terminator, BinaryConsumer consumer, void* context, unsigned long timeout, bool* stopped);
 
 	void WriteCommand(const char* command);
 	bool ReadResponse(const char* pattern, unsigned long timeout, std::string* capture);
+	bool ReadResponse(const ResponsePattern& pattern, unsigned long timeout, std::string* capture);
+	bool ReadResponse(const char* pattern, unsigned long timeout, const char** capture, int* captureLength);
+	bool ReadResponse(const ResponsePattern& pattern, unsigned long timeout, const char** capture, int* captureLength);
 	bool WriteCommandAndReadResponse(const char* command, const char* pattern, unsigned long timeout, std::string* capture);
+	bool WriteCommandAndReadResponse(const char* command, const ResponsePattern& pattern, unsigned long timeout, std::string* capture);
 
 	bool ReadResponseQHTTPREAD(char* data, int dataSize, unsigned long timeout);
 
+	bool PollResponse(const char** response, int* responseLength);
+	int PollBinary(byte* data, int dataSize);
+	bool ReadUnsolicitedResponse(unsigned long timeout);
+
 };
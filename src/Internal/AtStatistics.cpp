@@ -0,0 +1,103 @@
+#include "../Wio3GConfig.h"
+#include "AtStatistics.h"
+
+#include <string.h>
+
+#ifdef WIO_AT_STATISTICS
+
+const unsigned long AtStatistics::BucketLimit[AT_STATISTICS_BUCKET_NUM] = { 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000, 0xffffffff };
+
+AtStatistics::Entry AtStatistics::_Entries[AT_STATISTICS_ENTRY_NUM];
+int AtStatistics::_EntryNum = 0;
+int AtStatistics::_Pending = -1;
+unsigned long AtStatistics::_BeginTime = 0;
+
+// Find or add the entry of a command prefix.
+int AtStatistics::Find(const char* command, int commandLength)
+{
+	for (int i = 0; i < _EntryNum; i++) {
+		if (strncmp(_Entries[i].Command, command, commandLength) == 0 && _Entries[i].Command[commandLength] == '\0') return i;
+	}
+
+	int index;
+	if (_EntryNum < AT_STATISTICS_ENTRY_NUM - 1) {
+		index = _EntryNum++;
+		memcpy(_Entries[index].Command, command, commandLength);
+		_Entries[index].Command[commandLength] = '\0';
+	}
+	else {
+		index = AT_STATISTICS_ENTRY_NUM - 1;
+		if (_EntryNum < AT_STATISTICS_ENTRY_NUM) {
+			_EntryNum++;
+			strcpy(_Entries[index].Command, "*");
+		}
+	}
+
+	return index;
+}
+
+// The prefix is the command up to '=', '?' or ';', e.g. "AT+QIRD" of "AT+QIRD=0,1500".
+void AtStatistics::Begin(const char* command)
+{
+	int commandLength = strcspn(command, "=?;");
+	if (commandLength > AT_STATISTICS_COMMAND_MAX_LENGTH) commandLength = AT_STATISTICS_COMMAND_MAX_LENGTH;
+
+	_Pending = Find(command, commandLength);
+	_BeginTime = millis();
+}
+
+void AtStatistics::Response(const char* response)
+{
+	if (_Pending < 0) return;
+
+	// The prompt of AT+QISEND is read as ">" without its space, and ends the command like a final result code.
+	if (strcmp(response, "OK") != 0 && strcmp(response, "ERROR") != 0 && response[0] != '>' &&
+		strcmp(response, "SEND OK") != 0 && strcmp(response, "SEND FAIL") != 0 &&
+		strncmp(response, "+CME ERROR:", 11) != 0 && strncmp(response, "+CMS ERROR:", 11) != 0 &&
+		strncmp(response, "CONNECT", 7) != 0 && strcmp(response, "NO CARRIER") != 0) return;
+
+	Entry* entry = &_Entries[_Pending];
+	_Pending = -1;
+
+	unsigned long latency = millis() - _BeginTime;
+	int bucket = 0;
+	while (latency > BucketLimit[bucket]) bucket++;
+	entry->Count[bucket]++;
+	if (latency > entry->MaxLatency) entry->MaxLatency = latency;
+}
+
+void AtStatistics::Timeout()
+{
+	if (_Pending < 0) return;
+
+	_Entries[_Pending].Timeout++;
+	_Pending = -1;
+}
+
+void AtStatistics::Overflow()
+{
+	if (_Pending < 0) return;
+
+	_Entries[_Pending].Overflow++;
+}
+
+int AtStatistics::Size()
+{
+	return _EntryNum;
+}
+
+const AtStatistics::Entry* AtStatistics::Get(int index)
+{
+	if (index < 0 || _EntryNum <= index) return NULL;
+
+	return &_Entries[index];
+}
+
+void AtStatistics::Clear()
+{
+	memset(_Entries, 0, sizeof(_Entries));
+	_EntryNum = 0;
+	_Pending = -1;
+}
+
+#endif // WIO_AT_STATISTICS
@@ -0,0 +1,55 @@
+#pragma once
+
+#ifdef WIO_AT_STATISTICS
+
+#define AT_STATISTICS_BEGIN(command)		AtStatistics::Begin(command)
+#define AT_STATISTICS_RESPONSE(response)	AtStatistics::Response(response)
+#define AT_STATISTICS_TIMEOUT()				AtStatistics::Timeout()
+#define AT_STATISTICS_OVERFLOW()			AtStatistics::Overflow()
+
+#define AT_STATISTICS_ENTRY_NUM				(16)	// The last entry counts the commands that did not fit.
+#define AT_STATISTICS_COMMAND_MAX_LENGTH	(11)
+#define AT_STATISTICS_BUCKET_NUM			(12)
+
+// Latency from writing an AT command to its final result code, per command prefix ("AT+QIRD", "AT+CSQ", ...).
+class AtStatistics
+{
+public:
+	struct Entry {
+		char Command[AT_STATISTICS_COMMAND_MAX_LENGTH + 1];
+		unsigned long Count[AT_STATISTICS_BUCKET_NUM];	// Count[i] is the number of results within BucketLimit[i] milliseconds.
+		unsigned long Timeout;			// No final result code within the timeout of the read.
+		unsigned long Overflow;			// A response line was longer than the buffer.
+		unsigned long MaxLatency;		// [msec.]
+	};
+
+	static const unsigned long BucketLimit[AT_STATISTICS_BUCKET_NUM];
+
+private:
+	static Entry _Entries[AT_STATISTICS_ENTRY_NUM];
+	static int _EntryNum;
+	static int _Pending;				// Entry of the command waiting for its final result code, or -1.
+	static unsigned long _BeginTime;
+
+	static int Find(const char* command, int commandLength);
+
+public:
+	static void Begin(const char* command);
+	static void Response(const char* response);
+	static void Timeout();
+	static void Overflow();
+
+	static int Size();
+	static const Entry* Get(int index);
+	static void Clear();
+
+};
+
+#else
+
+#define AT_STATISTICS_BEGIN(command)
+#define AT_STATISTICS_RESPONSE(response)
+#define AT_STATISTICS_TIMEOUT()
+#define AT_STATISTICS_OVERFLOW()
+
+#endif // WIO_AT_STATISTICS
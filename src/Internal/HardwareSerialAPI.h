@@ -0,0 +1,48 @@
+#pragma once
+
+#include "SerialAPI.h"
+
+#define SERIAL_READ_BUFFER_SIZE	(2048)	// Holds a 1500-byte AT+QIRD response with its header.
+
+// Transport over a HardwareSerial of the core, e.g. SerialModule.
+class HardwareSerialAPI : public SerialAPI
+{
+private:
+	HardwareSerial* _Serial;
+	int _ReadBufferSize;
+	mutable int _HighWater;
+	mutable bool _Full;
+	mutable unsigned long _FullSamples;
+
+	// The core receives into its ring buffer from the UART interrupt and drives RTS. Its fill level is sampled here, on Available() and Read().
+	// Overruns of the USART are not visible through HardwareSerial, so only full samples are counted.
+	int Sample() const
+	{
+		int size = _Serial->available();
+		if (size > _HighWater) _HighWater = size;
+		bool full = size >= _ReadBufferSize - 1;
+		if (full && !_Full) _FullSamples++;
+		_Full = full;
+		return size;
+	}
+
+public:
+	HardwareSerialAPI(HardwareSerial* serial, int readBufferSize = SERIAL_READ_BUFFER_SIZE) : _Serial(serial), _ReadBufferSize(readBufferSize), _HighWater(0), _Full(false), _FullSamples(0) {}
+	virtual void SetReadBufferSize(int size) { _ReadBufferSize = size; }
+	virtual void Begin(int baud) { _Serial->setReadBufferSize(_ReadBufferSize); _Serial->begin(baud); }
+	virtual void SetWriteTimeout(unsigned long timeout) { _Serial->setWriteTimeout(timeout); }
+	virtual unsigned long GetWriteTimeout() const { return _Serial->getWriteTimeout(); }
+	virtual void Write(byte data) { _Serial->write(data); }
+	virtual void Write(const byte* data, int dataSize) { _Serial->write(data, dataSize); }
+	virtual bool Available() const { return Sample() >= 1 ? true : false; }
+	virtual byte Read() { Sample(); return _Serial->read(); }
+	virtual int Read(byte* data, int dataSize)
+	{
+		int size = Sample();
+		if (size > dataSize) size = dataSize;
+		if (size <= 0) return 0;
+		return _Serial->readBytes((char*)data, size);
+	}
+	virtual void GetReceiveStatistics(ReceiveStatistics* statistics) const { statistics->BufferSize = _ReadBufferSize; statistics->HighWater = _HighWater; statistics->FullSamples = _FullSamples; }
+
+};
@@ -0,0 +1,311 @@
+#include "../Wio3GConfig.h"
+#include "ResponsePattern.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#define PATTERN_MAX_LENGTH	(255)
+
+#define STATE_START			((State)1 << POSITION_MAX)
+
+enum PositionType {
+	POSITION_CHAR,
+	POSITION_ANY,
+	POSITION_DIGIT,
+	POSITION_SPACE,
+	POSITION_NOT_SPACE,
+	POSITION_SET,
+	POSITION_NOT_SET,
+};
+
+static int HexToInt(char ch)
+{
+	if ('0' <= ch && ch <= '9') return ch - '0';
+	if ('a' <= ch && ch <= 'f') return ch - 'a' + 10;
+	if ('A' <= ch && ch <= 'F') return ch - 'A' + 10;
+	return 0;
+}
+
+static char EscapeToChar(const char* ptr)
+{
+	switch (ptr[1]) {
+	case 'b': return '\b';
+	case 'f': return '\f';
+	case 'n': return '\n';
+	case 'r': return '\r';
+	case 't': return '\t';
+	case 'v': return '\v';
+	case 'x': return (char)(HexToInt(ptr[2]) << 4 | HexToInt(ptr[3]));
+	default:  return ptr[1];
+	}
+}
+
+static int EscapeLength(const char* ptr)
+{
+	return ptr[1] == 'x' ? 4 : 2;
+}
+
+// As SLRE: \ before one of its metacharacters, or \xHH.
+static bool IsValidEscape(const char* ptr, const char* end)
+{
+	if (ptr + 1 >= end) return false;
+	if (ptr[1] == 'x') return ptr + 3 < end && isxdigit((unsigned char)ptr[2]) && isxdigit((unsigned char)ptr[3]);
+
+	return ptr[1] != '\0' && strchr("^$().[]*+?|\\Ssdbfnrtv", ptr[1]) != NULL;
+}
+
+ResponsePattern::ResponsePattern(const char* pattern) : _Pattern(pattern), _Valid(false), _BeginAnchored(false), _EndAnchored(false), _Nullable(false), _PositionNum(0), _First(0), _Last(0)
+{
+	for (int i = 0; i < POSITION_MAX; i++) _Follow[i] = 0;
+
+	_Valid = Compile();
+}
+
+bool ResponsePattern::Compile()
+{
+	int length = strlen(_Pattern);
+	if (length > PATTERN_MAX_LENGTH) return false;
+
+	const char* ptr = _Pattern;
+	const char* end = _Pattern + length;
+
+	if (ptr < end && *ptr == '^') {
+		_BeginAnchored = true;
+		ptr++;
+	}
+	if (ptr < end && end[-1] == '$') {
+		int backslashNum = 0;
+		for (const char* p = end - 2; p >= ptr && *p == '\\'; p--) backslashNum++;
+		if (backslashNum % 2 == 0) {
+			_EndAnchored = true;
+			end--;
+		}
+	}
+
+	Fragment fragment;
+	if (!CompileAlternation(&ptr, end, &fragment)) return false;
+	if (ptr != end) return false;	// Unbalanced brackets.
+
+	_First = fragment.First;
+	_Last = fragment.Last;
+	_Nullable = fragment.Nullable;
+
+	return true;
+}
+
+bool ResponsePattern::CompileAlternation(const char** ptr, const char* end, Fragment* fragment)
+{
+	if (!CompileSequence(ptr, end, fragment)) return false;
+
+	while (*ptr < end && **ptr == '|') {
+		(*ptr)++;
+
+		Fragment branch;
+		if (!CompileSequence(ptr, end, &branch)) return false;
+		fragment->First |= branch.First;
+		fragment->Last |= branch.Last;
+		fragment->Nullable = fragment->Nullable || branch.Nullable;
+	}
+
+	return true;
+}
+
+bool ResponsePattern::CompileSequence(const char** ptr, const char* end, Fragment* fragment)
+{
+	fragment->First = 0;
+	fragment->Last = 0;
+	fragment->Nullable = true;
+
+	while (*ptr < end && **ptr != '|' && **ptr != ')') {
+		Fragment atom;
+		if (!CompileAtom(ptr, end, &atom)) return false;
+
+		if (*ptr < end && (**ptr == '*' || **ptr == '+' || **ptr == '?')) {
+			char quantifier = **ptr;
+			(*ptr)++;
+			if (*ptr < end && **ptr == '?') (*ptr)++;	// Non-greedy does not change whether it matches.
+
+			if (quantifier != '?') AddFollow(atom.Last, atom.First);
+			if (quantifier != '+') atom.Nullable = true;
+		}
+
+		AddFollow(fragment->Last, atom.First);
+		fragment->First |= fragment->Nullable ? atom.First : 0;
+		fragment->Last = atom.Last | (atom.Nullable ? fragment->Last : 0);
+		fragment->Nullable = fragment->Nullable && atom.Nullable;
+	}
+
+	return true;
+}
+
+bool ResponsePattern::CompileAtom(const char** ptr, const char* end, Fragment* fragment)
+{
+	const char* p = *ptr;
+
+	switch (*p) {
+	case '(':
+		*ptr = p + 1;
+		if (!CompileAlternation(ptr, end, fragment)) return false;
+		if (*ptr >= end || **ptr != ')') return false;
+		(*ptr)++;
+		return true;
+
+	case '[':
+	{
+		const char* set = p + 1;
+		bool invert = set < end && *set == '^';
+		if (invert) set++;
+		const char* setEnd;
+		for (setEnd = set; setEnd < end && *setEnd != ']'; ) {
+			if (*setEnd == '\\' && !IsValidEscape(setEnd, end)) return false;
+			setEnd += *setEnd == '\\' ? EscapeLength(setEnd) : 1;
+		}
+		if (setEnd >= end) return false;
+		*ptr = setEnd + 1;
+		return AddPosition(invert ? POSITION_NOT_SET : POSITION_SET, '\0', set, setEnd - set, fragment);
+	}
+
+	case '\\':
+		if (!IsValidEscape(p, end)) return false;
+		*ptr = p + EscapeLength(p);
+		switch (p[1]) {
+		case 'd': return AddPosition(POSITION_DIGIT, '\0', NULL, 0, fragment);
+		case 's': return AddPosition(POSITION_SPACE, '\0', NULL, 0, fragment);
+		case 'S': return AddPosition(POSITION_NOT_SPACE, '\0', NULL, 0, fragment);
+		default:  return AddPosition(POSITION_CHAR, EscapeToChar(p), NULL, 0, fragment);
+		}
+
+	case '.':
+		*ptr = p + 1;
+		return AddPosition(POSITION_ANY, '\0', NULL, 0, fragment);
+
+	case '*':
+	case '+':
+	case '?':
+	case '^':
+	case '$':
+	case ']':
+		return false;
+
+	default:
+		*ptr = p + 1;
+		return AddPosition(POSITION_CHAR, *p, NULL, 0, fragment);
+	}
+}
+
+bool ResponsePattern::AddPosition(uint8_t type, char ch, const char* set, int setLength, Fragment* fragment)
+{
+	if (_PositionNum >= POSITION_MAX) return false;
+
+	Position& position = _Positions[_PositionNum];
+	position.Type = type;
+	position.Char = ch;
+	position.SetOffset = set != NULL ? set - _Pattern : 0;
+	position.SetLength = setLength;
+
+	fragment->First = (State)1 << _PositionNum;
+	fragment->Last = fragment->First;
+	fragment->Nullable = false;
+
+	_PositionNum++;
+
+	return true;
+}
+
+void ResponsePattern::AddFollow(State from, State to)
+{
+	while (from != 0) {
+		int index = __builtin_ctz(from);
+		from &= from - 1;
+		_Follow[index] |= to;
+	}
+}
+
+bool ResponsePattern::IsMatchPosition(const Position& position, char ch) const
+{
+	switch (position.Type) {
+	case POSITION_CHAR:      return ch == position.Char;
+	case POSITION_ANY:       return true;
+	case POSITION_DIGIT:     return isdigit((unsigned char)ch) ? true : false;
+	case POSITION_SPACE:     return isspace((unsigned char)ch) ? true : false;
+	case POSITION_NOT_SPACE: return isspace((unsigned char)ch) ? false : true;
+	case POSITION_SET:       return IsMatchSet(&_Pattern[position.SetOffset], position.SetLength, ch);
+	case POSITION_NOT_SET:   return !IsMatchSet(&_Pattern[position.SetOffset], position.SetLength, ch);
+	default:                 return false;
+	}
+}
+
+bool ResponsePattern::IsMatchSet(const char* set, int setLength, char ch) const
+{
+	int i = 0;
+	while (i < setLength) {
+		if (set[i] == '\\') {
+			switch (set[i + 1]) {
+			case 'd': if (isdigit((unsigned char)ch)) return true; break;
+			case 's': if (isspace((unsigned char)ch)) return true; break;
+			case 'S': if (!isspace((unsigned char)ch)) return true; break;
+			default:  if (ch == EscapeToChar(&set[i])) return true; break;
+			}
+			i += EscapeLength(&set[i]);
+		}
+		else if (set[i] != '-' && i + 2 < setLength && set[i + 1] == '-') {
+			if (set[i] <= ch && ch <= set[i + 2]) return true;
+			i += 3;
+		}
+		else {
+			if (ch == set[i]) return true;
+			i++;
+		}
+	}
+
+	return false;
+}
+
+ResponsePattern::State ResponsePattern::Begin() const
+{
+	return STATE_START;
+}
+
+ResponsePattern::State ResponsePattern::Step(State state, char ch) const
+{
+	State candidates = (state & STATE_START) || !_BeginAnchored ? _First : 0;
+	State active = state & ~STATE_START;
+	while (active != 0) {
+		int index = __builtin_ctz(active);
+		active &= active - 1;
+		candidates |= _Follow[index];
+	}
+
+	State next = 0;
+	while (candidates != 0) {
+		int index = __builtin_ctz(candidates);
+		candidates &= candidates - 1;
+		if (IsMatchPosition(_Positions[index], ch)) next |= (State)1 << index;
+	}
+
+	return next;
+}
+
+bool ResponsePattern::IsAccepted(State state) const
+{
+	if (state & _Last) return true;
+	if (_Nullable && ((state & STATE_START) || !_BeginAnchored)) return true;
+
+	return false;
+}
+
+bool ResponsePattern::Match(const char* str, int length) const
+{
+	if (!_Valid) return false;
+
+	State state = Begin();
+	if (!_EndAnchored && IsAccepted(state)) return true;
+
+	for (int i = 0; i < length; i++) {
+		state = Step(state, str[i]);
+		if (!_EndAnchored && IsAccepted(state)) return true;
+		if (state == 0 && _BeginAnchored) return false;
+	}
+
+	return _EndAnchored && IsAccepted(state);
+}
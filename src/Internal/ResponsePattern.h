@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+// Response pattern compiled once into a position automaton (Glushkov NFA).
+// Supports the SLRE subset used for AT responses: ^ $ . [] [^] \d \s \S \xHH ( | ) * + ?
+// Other escapes are valid only before a metacharacter of SLRE (^$().[]*+?|\ and b f n r t v). \D and the like make the pattern invalid, also inside [] where SLRE takes them as literals.
+// The pattern string is referenced, not copied. It must outlive the object.
+class ResponsePattern
+{
+public:
+	typedef uint32_t State;
+
+	enum {
+		POSITION_MAX = 31,	// bit 31 of State is used as the start marker.
+	};
+
+private:
+	struct Position
+	{
+		uint8_t Type;
+		char Char;
+		uint8_t SetOffset;
+		uint8_t SetLength;
+	};
+
+	const char* _Pattern;
+	bool _Valid;
+	bool _BeginAnchored;
+	bool _EndAnchored;
+	bool _Nullable;
+	int _PositionNum;
+	Position _Positions[POSITION_MAX];
+	State _First;
+	State _Last;
+	State _Follow[POSITION_MAX];
+
+	struct Fragment
+	{
+		State First;
+		State Last;
+		bool Nullable;
+	};
+
+	bool Compile();
+	bool CompileAlternation(const char** ptr, const char* end, Fragment* fragment);
+	bool CompileSequence(const char** ptr, const char* end, Fragment* fragment);
+	bool CompileAtom(const char** ptr, const char* end, Fragment* fragment);
+	bool AddPosition(uint8_t type, char ch, const char* set, int setLength, Fragment* fragment);
+	void AddFollow(State from, State to);
+	bool IsMatchPosition(const Position& position, char ch) const;
+	bool IsMatchSet(const char* set, int setLength, char ch) const;
+
+public:
+	ResponsePattern(const char* pattern);
+
+	const char* GetPattern() const { return _Pattern; }
+	bool IsValid() const { return _Valid; }
+	bool IsEndAnchored() const { return _EndAnchored; }
+
+	State Begin() const;
+	State Step(State state, char ch) const;
+	bool IsAccepted(State state) const;
+
+	bool Match(const char* str, int length) const;
+
+};
@@ -1,15 +1,27 @@
 #pragma once
 
+// Byte transport to the module. Implement it to run Wio3G on another UART or off-target.
 class SerialAPI
 {
-private:
-	HardwareSerial* _Serial;
-
 public:
-	SerialAPI(HardwareSerial* serial) : _Serial(serial) {}
-	void Begin(int baud) { _Serial->begin(baud); }
-	void Write(byte data) { _Serial->write(data); }
-	bool Available() const { return _Serial->available() >= 1 ? true : false; }
-	byte Read() { return _Serial->read(); }
+	struct ReceiveStatistics {
+		int BufferSize;				// 0 if unknown.
+		int HighWater;				// Most bytes seen waiting in the receive buffer.
+		unsigned long FullSamples;	// Heuristic: times a sample found the receive buffer full. Not an overrun count; with RTS flow control a full buffer only holds the module off.
+	};
+
+	virtual ~SerialAPI() {}
+	virtual void Begin(int baud) = 0;
+	virtual void SetWriteTimeout(unsigned long timeout) = 0;
+	virtual unsigned long GetWriteTimeout() const = 0;
+	virtual void Write(byte data) = 0;
+	virtual void Write(const byte* data, int dataSize) = 0;
+	virtual bool Available() const = 0;
+	virtual byte Read() = 0;
+	// Read up to dataSize bytes that have already arrived. Never waits.
+	virtual int Read(byte* data, int dataSize) = 0;
+	// Takes effect at the next Begin. Ignored by transports without a receive buffer of their own.
+	virtual void SetReadBufferSize(int size) {}
+	virtual void GetReceiveStatistics(ReceiveStatistics* statistics) const { statistics->BufferSize = 0; statistics->HighWater = 0; statistics->FullSamples = 0; }
 
 };
@@ -13,12 +13,52 @@
 
 #define CONNECT_ID_NUM				(12)
 #define POLLING_INTERVAL			(100)
+#define URC_FALLBACK_INTERVAL		(1000)
+#define BOOT_TIMEOUT				(10000)
+#define BOOT_PROBE_INTERVAL			(1000)	// AT is sent when RDY has not come for this long.
+#define REGISTRATION_FALLBACK_INTERVAL	(5000)
+#define BAUD_RATE_DEFAULT			(115200)	// The module starts at this rate. AT+IPR is not saved with AT&W.
+#define BAUD_RATE_PROBE_NUM			(3)
+
+#define SOCKET_SEND_MAX_LENGTH		(1460)
+#define SOCKET_SEND_WINDOW			(SOCKET_SEND_MAX_LENGTH * 4)
+#define SOCKET_SEND_ACK_TIMEOUT		(60000)
+#define SOCKET_RECEIVE_MAX_LENGTH	(1500)
+
+#define ACTIVATE_TIMEOUT			(150000)
+#define SOCKET_OPEN_TIMEOUT			(150000)
+#define HTTP_GET_TIMEOUT			(60000)
+#define HTTP_GET_POLL_SIZE			(512)		// [byte] Body read by one Poll(), so a long body does not hold up loop().
 
 #define HTTP_POST_USER_AGENT		"QUECTEL_MODULE"
 #define HTTP_POST_CONTENT_TYPE		"application/json"
+#define HTTP_POST_CHUNK_SIZE		(256)
+#define HTTP_POST_INPUT_TIME		(60)	// [sec.] <input_time> of AT+QHTTPPOST. The module gives up a body that has not all come by then.
+#define HTTP_POST_RESPONSE_TIME		(60)	// [sec.] <rsptime> of AT+QHTTPPOST.
+
+// Fixed parts of the POST header, written in this order around the URI, host, User-Agent, Content-Type and caller headers.
+#define HTTP_POST_HEADER_1			"POST "
+#define HTTP_POST_HEADER_2			" HTTP/1.1\r\nHost: "
+#define HTTP_POST_HEADER_3			"\r\nAccept: */*\r\n"
+#define HTTP_POST_HEADER_4			"Connection: Keep-Alive\r\nContent-Type: "
+#define HTTP_POST_HEADER_5			"\r\n"
 
 #define LINEAR_SCALE(val, inMin, inMax, outMin, outMax)	(((val) - (inMin)) / ((inMax) - (inMin)) * ((outMax) - (outMin)) + (outMin))
 
+////////////////////////////////////////////////////////////////////////////////////////
+// Response patterns
+
+// The patterns of the frequent responses, compiled once. AtSerial compiles a const char* pattern on every call.
+static const ResponsePattern PatternOk("^OK$");
+static const ResponsePattern PatternOkOrError("^(OK|ERROR)$");
+static const ResponsePattern PatternPrompt("^>");
+static const ResponsePattern PatternSendOk("^SEND OK$");
+static const ResponsePattern PatternQisendQuery("^\\+QISEND: [0-9]+,[0-9]+,([0-9]+)$");
+static const ResponsePattern PatternQird("^\\+QIRD: (.*)$");
+static const ResponsePattern PatternCsq("^\\+CSQ: ([0-9]+),[0-9]+$");
+static const ResponsePattern PatternConnect("^CONNECT$");
+static const ResponsePattern PatternQhttpreadEnd("^\\+QHTTPREAD: 0$");
+
 ////////////////////////////////////////////////////////////////////////////////////////
 // Helper functions
 
@@ -45,6 +85,77 @@ static bool SplitUrl(const char* url, const char** host, int* hostLength, const
 	return true;
 }
 
+// Whether header lines contain a field with name (case-insensitive).
+static bool HasHttpHeader(const char* headers, const char* name)
+{
+	int nameLength = strlen(name);
+	for (const char* line = headers; *line != '\0'; ) {
+		if (strncasecmp(line, name, nameLength) == 0 && line[nameLength] == ':') return true;
+
+		const char* next = strstr(line, "\r\n");
+		if (next == NULL) break;
+		line = next + 2;
+	}
+
+	return false;
+}
+
+// Parse the parameters of +CREG/+CGREG without allocating.
+// The URC is <stat>[,<lac>,<ci>[,<AcT>]] and the read command response is <n>,<stat>[,<lac>,<ci>[,<AcT>]].
+// They are told apart by the number of fields and whether the second field is the quoted <lac>.
+static bool ParseRegistration(const char* parameter, bool* unsolicited, int* status, long* lac, long* ci)
+{
+	const char* fields[5];
+	int fieldNum = 0;
+	fields[fieldNum++] = parameter;
+	for (const char* ptr = parameter; *ptr != '\0' && fieldNum < 5; ptr++) {
+		if (*ptr == ',') fields[fieldNum++] = ptr + 1;
+	}
+
+	*unsolicited = fieldNum == 1 || fields[1][0] == '"';
+	int statIndex = *unsolicited ? 0 : 1;
+	if (fieldNum <= statIndex) return false;
+	*status = atoi(fields[statIndex]);
+
+	*lac = -1;
+	*ci = -1;
+	if (fieldNum >= statIndex + 3) {
+		*lac = strtol(fields[statIndex + 1] + 1, NULL, 16);
+		*ci = strtol(fields[statIndex + 2] + 1, NULL, 16);
+	}
+
+	return true;
+}
+
+static void UpdateRegistration(Wio3G::RegistrationStatus* registration, int status, long lac, long ci)
+{
+	if (status != registration->Status) registration->ChangedTime = millis();
+	registration->Status = status;
+	if (lac >= 0) {
+		registration->LocationAreaCode = lac;
+		registration->CellId = ci;
+	}
+}
+
+// Convert <rssi> of +CSQ to dBm. 99 (not detectable) is -999.
+static int RssiToDbm(int rssi)
+{
+	if (rssi == 0) return -113;
+	else if (rssi == 1) return -111;
+	else if (2 <= rssi && rssi <= 30) return (int)LINEAR_SCALE((double)rssi, 2, 30, -109, -53);
+	else if (rssi == 31) return -51;
+
+	return -999;
+}
+
+static bool CopyString(char* dst, int dstSize, const char* src)
+{
+	if ((int)strlen(src) + 1 > dstSize) return false;
+	strcpy(dst, src);
+
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////
 // Wio3G
 
@@ -77,22 +188,81 @@ bool Wio3G::IsBusy() const
 	return digitalRead(MODULE_STATUS_PIN) ? false : true;
 }
 
-bool Wio3G::IsRespond()
+// Wait for RDY after the module starts.
+// RDY is missed if the module was already up or the UART was not ready, so AT is also tried while STATUS is high.
+bool Wio3G::WaitForBoot(long timeout)
 {
-	auto writeTimeout = SerialModule.getWriteTimeout();
-	SerialModule.setWriteTimeout(10);
+	auto writeTimeout = _SerialAPI->GetWriteTimeout();
+	_SerialAPI->SetWriteTimeout(10);
 
+	bool ready = false;
 	Stopwatch sw;
 	sw.Restart();
-	while (!_AtSerial.WriteCommandAndReadResponse("AT", "^OK$", 500, NULL)) {
-		if (sw.ElapsedMilliseconds() >= 2000)
-		{
-			SerialModule.setWriteTimeout(writeTimeout);
-			return false;
+	while (true) {
+		if (_AtSerial.ReadResponse("^RDY$", BOOT_PROBE_INTERVAL, NULL)) {
+			ready = true;
+			break;
+		}
+		if (!IsBusy() && _AtSerial.WriteCommandAndReadResponse("AT", PatternOk, 100, NULL)) {
+			ready = true;
+			break;
+		}
+
+		DEBUG_PRINT(".");
+		if (sw.ElapsedMilliseconds() >= (unsigned long)timeout) break;
+	}
+
+	_SerialAPI->SetWriteTimeout(writeTimeout);
+	return ready;
+}
+
+// Check that the module answers at the current rate.
+bool Wio3G::ProbeBaudRate()
+{
+	for (int i = 0; i < BAUD_RATE_PROBE_NUM; i++) {
+		if (_AtSerial.WriteCommandAndReadResponse("AT", PatternOk, 100, NULL)) return true;
+	}
+
+	return false;
+}
+
+// Switch the module and the UART to baudRate and check it with AT.
+// If the check fails, the UART goes back to the current rate. The module may still be at baudRate.
+bool Wio3G::ChangeBaudRate(long baudRate)
+{
+	StringBuilder str;
+	if (!str.WriteFormat("AT+IPR=%ld", baudRate)) return false;
+	if (!_AtSerial.WriteCommandAndReadResponse(str.GetString(), PatternOk, 500, NULL)) return false;
+
+	_SerialAPI->Begin(baudRate);
+	if (!ProbeBaudRate()) {
+		_SerialAPI->Begin(_BaudRate);
+		return false;
+	}
+	_BaudRate = baudRate;
+
+	return true;
+}
+
+// Wait for the SIM. +CPIN: READY is caught by ReadResponseCallback; AT+CPIN? is the fallback.
+bool Wio3G::WaitForSimReady(long timeout)
+{
+	std::string response;
+
+	Stopwatch sw;
+	sw.Restart();
+	while (!_SimReady) {
+		if (!_AtSerial.WriteCommandAndReadResponse("AT+CPIN?", "^(OK|\\+CME ERROR: .*)$", 5000, &response)) return false;
+		if (response == "OK") break;
+
+		Stopwatch fallback;
+		fallback.Restart();
+		while (!_SimReady && fallback.ElapsedMilliseconds() < URC_FALLBACK_INTERVAL) {
+			if (sw.ElapsedMilliseconds() >= (unsigned long)timeout) return false;
+			_AtSerial.ReadUnsolicitedResponse(URC_FALLBACK_INTERVAL - fallback.ElapsedMilliseconds());
 		}
 	}
 
-	SerialModule.setWriteTimeout(writeTimeout);
 	return true;
 }
 
@@ -101,7 +271,6 @@ bool Wio3G::Reset()
 	digitalWrite(MODULE_RESET_PIN, HIGH);
 	delay(200);
 	digitalWrite(MODULE_RESET_PIN, LOW);
-	delay(300);
 
 	return true;
 }
@@ -116,26 +285,147 @@ bool Wio3G::TurnOn()
 	return true;
 }
 
+void Wio3G::PhaseClear()
+{
+	_PhaseTimes.PowerSupplyOn = -1;
+	_PhaseTimes.PowerKey = -1;
+	_PhaseTimes.FirstResponse = -1;
+	_PhaseTimes.SimReady = -1;
+	_PhaseTimes.CSRegistered = -1;
+	_PhaseTimes.PSRegistered = -1;
+	_PhaseTimes.ContextConfigured = -1;
+	_PhaseTimes.Activated = -1;
+	_PhaseTimes.FirstSocketOpened = -1;
+}
+
+// Record the time of a phase the first time it is reached.
+void Wio3G::PhaseMark(long* phase)
+{
+	if (*phase >= 0) return;
+
+	*phase = millis() - _PhaseOrigin;
+}
+
+void Wio3G::HttpClearConfig()
+{
+	_HttpSslConfigured = false;
+	_HttpRequestHeader = -1;
+}
+
+// Send only the HTTP/SSL settings that differ from the shadow.
+bool Wio3G::HttpConfig(bool ssl, int requestHeader)
+{
+	if (ssl && !_HttpSslConfigured) {
+		if (!_AtSerial.WriteCommandAndReadResponse("AT+QHTTPCFG=\"sslctxid\",1", PatternOk, 500, NULL)) return false;
+		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"sslversion\",1,4", PatternOk, 500, NULL)) return false;
+		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"ciphersuite\",1,\"0XFFFF\"", PatternOk, 500, NULL)) return false;
+		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"seclevel\",1,0", PatternOk, 500, NULL)) return false;
+		_HttpSslConfigured = true;
+	}
+
+	if (requestHeader != _HttpRequestHeader) {
+		_HttpRequestHeader = -1;
+		char str[40];
+		sprintf(str, "AT+QHTTPCFG=\"requestheader\",%d", requestHeader);
+		if (!_AtSerial.WriteCommandAndReadResponse(str, PatternOk, 500, NULL)) return false;
+		_HttpRequestHeader = requestHeader;
+	}
+
+	return true;
+}
+
 bool Wio3G::HttpSetUrl(const char* url)
 {
 	StringBuilder str;
 	if (!str.WriteFormat("AT+QHTTPURL=%d", strlen(url))) return false;
 	_AtSerial.WriteCommand(str.GetString());
-	if (!_AtSerial.ReadResponse("^CONNECT$", 500, NULL)) return false;
+	if (!_AtSerial.ReadResponse(PatternConnect, 500, NULL)) return false;
 
 	_AtSerial.WriteBinary((const byte*)url, strlen(url));
-	if (!_AtSerial.ReadResponse("^OK$", 500, NULL)) return false;
+	if (!_AtSerial.ReadResponse(PatternOk, 500, NULL)) return false;
 
 	return true;
 }
 
+void Wio3G::OnSocketEvent(int connectId, SocketEventType event)
+{
+	switch (event) {
+	case SOCKET_EVENT_RECEIVE:
+		_SocketReadable |= 1 << connectId;
+		break;
+	case SOCKET_EVENT_CLOSED:
+		_SocketClosed |= 1 << connectId;
+		break;
+	case SOCKET_EVENT_PDP_DEACTIVATED:
+		_SocketClosed = (1 << CONNECT_ID_NUM) - 1;
+		break;
+	}
+
+	if (_SocketEventCallback != NULL) _SocketEventCallback(connectId, event);
+}
+
 bool Wio3G::ReadResponseCallback(const char* response)
 {
+	// Both the URC and the response of AT+CPIN?. Not consumed.
+	if (strcmp(response, "+CPIN: READY") == 0) {
+		_SimReady = true;
+		return false;
+	}
+
+	// Registration is cached from both the URC and the read command response, but only the URC is consumed here.
+	if (strncmp(response, "+CREG: ", 7) == 0 || strncmp(response, "+CGREG: ", 8) == 0) {
+		bool ps = response[2] == 'G';
+		bool unsolicited;
+		int status;
+		long lac;
+		long ci;
+		if (!ParseRegistration(&response[ps ? 8 : 7], &unsolicited, &status, &lac, &ci)) return false;
+		UpdateRegistration(ps ? &_PSRegistration : &_CSRegistration, status, lac, ci);
+		if (status == 1 || status == 5) PhaseMark(ps ? &_PhaseTimes.PSRegistered : &_PhaseTimes.CSRegistered);
+		return unsolicited;
+	}
+
+	if (strncmp(response, "+QIURC: ", 8) != 0) return false;
+	const char* parameter = &response[8];
+
+	if (strncmp(parameter, "\"recv\",", 7) == 0) {
+		int connectId = atoi(&parameter[7]);
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId) return false;
+		OnSocketEvent(connectId, SOCKET_EVENT_RECEIVE);
+		return true;
+	}
+	if (strncmp(parameter, "\"closed\",", 9) == 0) {
+		int connectId = atoi(&parameter[9]);
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId) return false;
+		OnSocketEvent(connectId, SOCKET_EVENT_CLOSED);
+		return true;
+	}
+	if (strncmp(parameter, "\"pdpdeact\",", 11) == 0) {
+		OnSocketEvent(-1, SOCKET_EVENT_PDP_DEACTIVATED);
+		return true;
+	}
+
 	return false;
 }
 
-Wio3G::Wio3G() : _SerialAPI(&SerialModule), _AtSerial(&_SerialAPI, this), _Led()
+//! Use a transport other than SerialModule, e.g. a simulated module.
+Wio3G::Wio3G(SerialAPI* serial) : _SerialAPI(serial), _AtSerial(_SerialAPI, this), _Led(), _SocketReadable(0), _SocketClosed(0), _SocketEventCallback(NULL), _ConnectIdUsed(0), _ConnectIdSynced(false), _HttpSslConfigured(false), _HttpRequestHeader(-1)
 {
+	_Async.State = ASYNC_STATE_NONE;
+	_Async.Status = ASYNC_IDLE;
+	_Async.Result = -1;
+	_Async.Callback = NULL;
+
+	_SimReady = false;
+	ClearRegistration();
+
+	_PhaseOrigin = 0;
+	_PhaseOriginSet = false;
+	PhaseClear();
+
+	_BaudRate = BAUD_RATE_DEFAULT;
+	_BaudRateRequest = BAUD_RATE_DEFAULT;
+	_BaudRateFailed = false;
 }
 
 Wio3G::ErrorCodeType Wio3G::GetLastError() const
@@ -143,6 +433,37 @@ Wio3G::ErrorCodeType Wio3G::GetLastError() const
 	return _LastErrorCode;
 }
 
+//! Set the size of the module receive buffer. Call it before Init().
+void Wio3G::SetReadBufferSize(int size)
+{
+	_SerialAPI->SetReadBufferSize(size);
+}
+
+//! Get how full the module receive buffer has been, to size it. FullSamples is sampled, not an overrun count.
+void Wio3G::GetReceiveStatistics(SerialAPI::ReceiveStatistics* statistics) const
+{
+	_SerialAPI->GetReceiveStatistics(statistics);
+}
+
+//! Set the function called while waiting for the module, e.g. to do other work or enter a deeper sleep.
+/*!
+  \param hook NULL to busy-wait. Wio3G() sets Wio3GWaitForInterrupt, which executes WFI. Wio3G(SerialAPI*) busy-waits by default.
+*/
+void Wio3G::SetIdleHook(IdleHook hook, void* context)
+{
+	_AtSerial.SetIdleHook(hook, context);
+}
+
+//! Get the time spent waiting for the module and the part of it spent in the idle hook.
+/*!
+  \param command receives the statistics since the last AT command was written. Can be NULL.
+  \param total receives the statistics since start-up. Can be NULL.
+*/
+void Wio3G::GetWaitStatistics(AtSerial::WaitStatistics* command, AtSerial::WaitStatistics* total) const
+{
+	_AtSerial.GetWaitStatistics(command, total);
+}
+
 void Wio3G::Init()
 {
 	////////////////////
@@ -158,9 +479,9 @@ void Wio3G::Init()
 	// Main UART Interface
 	pinMode(MODULE_DTR_PIN, OUTPUT); digitalWrite(MODULE_DTR_PIN, LOW);
 
-	SerialModule.setReadBufferSize(100);
-	SerialModule.setWriteTimeout(0xffffffff);	// HAL_MAX_DELAY
-	SerialModule.begin(115200);
+	_SerialAPI->SetWriteTimeout(0xffffffff);	// HAL_MAX_DELAY
+	_SerialAPI->Begin(BAUD_RATE_DEFAULT);
+	_BaudRate = BAUD_RATE_DEFAULT;
 
 	////////////////////
 	// Led
@@ -176,7 +497,15 @@ void Wio3G::Init()
 
 void Wio3G::PowerSupplyCellular(bool on)
 {
+	if (!on) HttpClearConfig();
 	digitalWrite(MODULE_PWR_PIN, on ? HIGH : LOW);
+
+	if (on) {
+		_PhaseOrigin = millis();
+		_PhaseOriginSet = true;
+		PhaseClear();
+		_PhaseTimes.PowerSupplyOn = 0;
+	}
 }
 
 void Wio3G::PowerSupplyLed(bool on)
@@ -195,11 +524,67 @@ void Wio3G::LedSetRGB(uint8_t red, uint8_t green, uint8_t blue)
 	_Led.SetSingleLED(red, green, blue);
 }
 
+//! Set the module UART rate to negotiate in TurnOnOrReset.
+/*!
+  TurnOnOrReset switches to the rate with AT+IPR after boot and checks it with AT.
+  If the check fails, it returns to 115200 and does not try this rate again until SetBaudRate is called.
+  \param baudRate 115200, 230400, 460800 or 921600.
+  \return false if the rate is not supported.
+*/
+bool Wio3G::SetBaudRate(long baudRate)
+{
+	switch (baudRate) {
+	case 115200:
+	case 230400:
+	case 460800:
+	case 921600:
+		break;
+	default:
+		return RET_ERR(false, E_UNKNOWN);
+	}
+
+	_BaudRateRequest = baudRate;
+	_BaudRateFailed = false;
+
+	return RET_OK(true);
+}
+
+//! Get the current module UART rate.
+long Wio3G::GetBaudRate() const
+{
+	return _BaudRate;
+}
+
 bool Wio3G::TurnOnOrReset()
 {
-	std::string response;
+	_SocketReadable = 0;
+	_SocketClosed = 0;
+	_ConnectIdUsed = 0;
+	_ConnectIdSynced = false;
+	// An operation pending on the old module never completes, so drop it and its callback.
+	_Async.State = ASYNC_STATE_NONE;
+	_Async.Status = ASYNC_IDLE;
+	_Async.Result = -1;
+	_Async.Callback = NULL;
+	HttpClearConfig();
+	ClearRegistration();
+	_SimReady = false;
+
+	// Phases are timed from PowerSupplyCellular(true) if it came just before, otherwise from here.
+	if (!_PhaseOriginSet) {
+		_PhaseOrigin = millis();
+		PhaseClear();
+	}
+	_PhaseOriginSet = false;
+
+	// The module starts at the default rate.
+	if (_BaudRate != BAUD_RATE_DEFAULT) {
+		_SerialAPI->Begin(BAUD_RATE_DEFAULT);
+		_BaudRate = BAUD_RATE_DEFAULT;
+	}
 
-	if (IsRespond()) {
+	// STATUS is high while the module is on.
+	if (!IsBusy()) {
 		DEBUG_PRINTLN("Reset()");
 		if (!Reset()) return RET_ERR(false, E_UNKNOWN);
 	}
@@ -207,34 +592,42 @@ bool Wio3G::TurnOnOrReset()
 		DEBUG_PRINTLN("TurnOn()");
 		if (!TurnOn()) return RET_ERR(false, E_UNKNOWN);
 	}
+	PhaseMark(&_PhaseTimes.PowerKey);
 
-	Stopwatch sw;
-	sw.Restart();
-	while (!_AtSerial.WriteCommandAndReadResponse("AT", "^OK$", 500, NULL)) {
-		DEBUG_PRINT(".");
-		if (sw.ElapsedMilliseconds() >= 10000) return RET_ERR(false, E_UNKNOWN);
-	}
+	if (!WaitForBoot(BOOT_TIMEOUT)) return RET_ERR(false, E_UNKNOWN);
+	PhaseMark(&_PhaseTimes.FirstResponse);
 	DEBUG_PRINTLN("");
 
-	if (!_AtSerial.WriteCommandAndReadResponse("ATE0", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+	// Echo off, hardware flow control, URCs to the main UART and registration URCs with location, in one command line.
+	if (!_AtSerial.WriteCommandAndReadResponse("ATE0;+IFC=2,2;+QURCCFG=\"urcport\",\"uart1\";+CREG=2;+CGREG=2", PatternOk, 500, NULL)) return RET_ERR(false, E_UNKNOWN);
 	_AtSerial.SetEcho(false);
 
-	if (!_AtSerial.WriteCommandAndReadResponse("AT+IFC=2,2", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
-
-	sw.Restart();
-	while (true) {
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+CPIN?", "^(OK|\\+CME ERROR: .*)$", 5000, &response)) return RET_ERR(false, E_UNKNOWN);
-		if (response == "OK") break;
-		if (sw.ElapsedMilliseconds() >= 10000) return RET_ERR(false, E_UNKNOWN);
-		delay(POLLING_INTERVAL);
+	// Hardware flow control is on from here, which the higher rates need.
+	if (_BaudRateRequest != _BaudRate && !_BaudRateFailed) {
+		if (!ChangeBaudRate(_BaudRateRequest)) {
+			DEBUG_PRINTLN("### BAUD RATE FALLBACK ###");
+			_BaudRateFailed = true;
+			// The module may be at the new rate without answering. A reset brings it back to the default rate.
+			if (!ProbeBaudRate()) {
+				_PhaseOriginSet = true;
+				return TurnOnOrReset();
+			}
+		}
 	}
 
+	if (!WaitForSimReady(BOOT_TIMEOUT)) return RET_ERR(false, E_UNKNOWN);
+	PhaseMark(&_PhaseTimes.SimReady);
+
+	// A module just turned on or reset has no sockets.
+	_ConnectIdSynced = true;
+
 	return true;
 }
 
 bool Wio3G::TurnOff()
 {
-	if (!_AtSerial.WriteCommandAndReadResponse("AT+QPOWD", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+	HttpClearConfig();
+	if (!_AtSerial.WriteCommandAndReadResponse("AT+QPOWD", PatternOk, 500, NULL)) return RET_ERR(false, E_UNKNOWN);
 	if (!_AtSerial.ReadResponse("^POWERED DOWN$", 60000, NULL)) return RET_ERR(false, E_UNKNOWN);
 
 	return RET_OK(true);
@@ -302,25 +695,89 @@ int Wio3G::GetPhoneNumber(char* number, int numberSize)
 
 int Wio3G::GetReceivedSignalStrength()
 {
-	std::string response;
-	ArgumentParser parser;
+	const char* parameter;
+	int parameterLength;
 
 	_AtSerial.WriteCommand("AT+CSQ");
-	if (!_AtSerial.ReadResponse("^\\+CSQ: (.*)$", 500, &response)) return RET_ERR(INT_MIN, E_UNKNOWN);
+	if (!_AtSerial.ReadResponse(PatternCsq, 500, &parameter, &parameterLength)) return RET_ERR(INT_MIN, E_UNKNOWN);
+	int rssi = atoi(parameter);
 
-	parser.Parse(response.c_str());
-	if (parser.Size() != 2) return RET_ERR(INT_MIN, E_UNKNOWN);
-	int rssi = atoi(parser[0]);
+	if (!_AtSerial.ReadResponse(PatternOk, 500, NULL)) return RET_ERR(INT_MIN, E_UNKNOWN);
 
-	if (!_AtSerial.ReadResponse("^OK$", 500, NULL)) return RET_ERR(INT_MIN, E_UNKNOWN);
+	return RET_OK(RssiToDbm(rssi));
+}
+
+//! Read several values with one command line.
+/*!
+  The requested read-only commands are joined into one line (e.g. AT+GSN;+CIMI;+CSQ) so they cost a single round trip.
+  \param queryMask a combination of QueryType.
+  \param result receives the values. See QueryResult.
+  \return false if the module answered ERROR to any of the commands.
+*/
+bool Wio3G::Query(int queryMask, QueryResult* result)
+{
+	result->IMEI[0] = '\0';
+	result->IMSI[0] = '\0';
+	result->PhoneNumber[0] = '\0';
+	result->ReceivedSignalStrength = INT_MIN;
+	result->CSRegistrationStatus = -1;
+	result->PSRegistrationStatus = -1;
+
+	char command[40] = "AT";
+	if (queryMask & QUERY_IMEI) strcat(command, "+GSN;");
+	if (queryMask & QUERY_IMSI) strcat(command, "+CIMI;");
+	if (queryMask & QUERY_PHONE_NUMBER) strcat(command, "+CNUM;");
+	if (queryMask & QUERY_RECEIVED_SIGNAL_STRENGTH) strcat(command, "+CSQ;");
+	if (queryMask & QUERY_CS_REGISTRATION) strcat(command, "+CREG?;");
+	if (queryMask & QUERY_PS_REGISTRATION) strcat(command, "+CGREG?;");
+	int commandLength = strlen(command);
+	if (commandLength <= 2) return RET_ERR(false, E_UNKNOWN);
+	command[commandLength - 1] = '\0';	// Remove the last ';'.
+
+	const ResponsePattern pattern("^(.+)$");
+	ArgumentParser parser;
+	const char* response;
+	int responseLength;
+	bool imeiRead = false;
 
-	if (rssi == 0) return RET_OK(-113);
-	else if (rssi == 1) return RET_OK(-111);
-	else if (2 <= rssi && rssi <= 30) return RET_OK((int)LINEAR_SCALE((double)rssi, 2, 30, -109, -53));
-	else if (rssi == 31) return RET_OK(-51);
-	else if (rssi == 99) return RET_OK(-999);
+	_AtSerial.WriteCommand(command);
+	while (true) {
+		if (!_AtSerial.ReadResponse(pattern, 500, &response, &responseLength)) return RET_ERR(false, E_UNKNOWN);
+		if (strcmp(response, "OK") == 0) break;
+		if (strcmp(response, "ERROR") == 0 || strncmp(response, "+CME ERROR: ", 12) == 0) return RET_ERR(false, E_UNKNOWN);
+
+		if ('0' <= response[0] && response[0] <= '9') {
+			// +GSN and +CIMI have no prefix. They are answered in the order they were sent.
+			if ((queryMask & QUERY_IMEI) && !imeiRead) {
+				if (!CopyString(result->IMEI, sizeof(result->IMEI), response)) return RET_ERR(false, E_UNKNOWN);
+				imeiRead = true;
+			}
+			else if (queryMask & QUERY_IMSI) {
+				if (!CopyString(result->IMSI, sizeof(result->IMSI), response)) return RET_ERR(false, E_UNKNOWN);
+			}
+		}
+		else if (strncmp(response, "+CNUM: ", 7) == 0) {
+			if (result->PhoneNumber[0] != '\0') continue;
+			parser.Parse(&response[7]);
+			if (parser.Size() < 2) return RET_ERR(false, E_UNKNOWN);
+			if (!CopyString(result->PhoneNumber, sizeof(result->PhoneNumber), parser[1])) return RET_ERR(false, E_UNKNOWN);
+		}
+		else if (strncmp(response, "+CSQ: ", 6) == 0) {
+			result->ReceivedSignalStrength = RssiToDbm(atoi(&response[6]));
+		}
+		else if (strncmp(response, "+CREG: ", 7) == 0) {
+			parser.Parse(&response[7]);
+			if (parser.Size() < 2) return RET_ERR(false, E_UNKNOWN);
+			result->CSRegistrationStatus = atoi(parser[1]);
+		}
+		else if (strncmp(response, "+CGREG: ", 8) == 0) {
+			parser.Parse(&response[8]);
+			if (parser.Size() < 2) return RET_ERR(false, E_UNKNOWN);
+			result->PSRegistrationStatus = atoi(parser[1]);
+		}
+	}
 
-	return RET_OK(-999);
+	return RET_OK(true);
 }
 
 bool Wio3G::GetTime(struct tm* tim)
@@ -329,7 +786,7 @@ bool Wio3G::GetTime(struct tm* tim)
 
 	_AtSerial.WriteCommand("AT+QLTS=1");
 	if (!_AtSerial.ReadResponse("^\\+QLTS: (.*)$", 500, &response)) return RET_ERR(false, E_UNKNOWN);
-	if (!_AtSerial.ReadResponse("^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+	if (!_AtSerial.ReadResponse(PatternOk, 500, NULL)) return RET_ERR(false, E_UNKNOWN);
 
 	if (strlen(response.c_str()) != 24) return RET_ERR(false, E_UNKNOWN);
 	const char* parameter = response.c_str();
@@ -360,27 +817,49 @@ bool Wio3G::GetTime(struct tm* tim)
 	return RET_OK(true);
 }
 
-bool Wio3G::WaitForCSRegistration(long timeout)
+void Wio3G::ClearRegistration()
 {
-	std::string response;
-	ArgumentParser parser;
+	_CSRegistration.Status = -1;
+	_CSRegistration.LocationAreaCode = -1;
+	_CSRegistration.CellId = -1;
+	_CSRegistration.ChangedTime = millis();
+	_PSRegistration = _CSRegistration;
+}
+
+// Read the registration with AT+CREG?/AT+CGREG?. The cache is updated by ReadResponseCallback.
+bool Wio3G::QueryRegistration(bool ps)
+{
+	_AtSerial.WriteCommand(ps ? "AT+CGREG?" : "AT+CREG?");
+	if (!_AtSerial.ReadResponse(PatternOk, 500, NULL)) return false;
+
+	return true;
+}
+
+// Wait until the cached registration status becomes registered.
+// The URC wakes the wait. The status is also read at a slow interval in case a URC was missed.
+bool Wio3G::WaitForRegistration(bool ps, long timeout)
+{
+	const RegistrationStatus* registration = ps ? &_PSRegistration : &_CSRegistration;
 
 	Stopwatch sw;
 	sw.Restart();
+	if (!QueryRegistration(ps)) return false;
+	Stopwatch fallback;
+	fallback.Restart();
 	while (true) {
-		int status;
-
-		_AtSerial.WriteCommand("AT+CREG?");
-		if (!_AtSerial.ReadResponse("^\\+CREG: (.*)$", 500, &response)) return RET_ERR(false, E_UNKNOWN);
-		parser.Parse(response.c_str());
-		if (parser.Size() < 2) return RET_ERR(false, E_UNKNOWN);
-		//resultCode = atoi(parser[0]);
-		status = atoi(parser[1]);
-		if (!_AtSerial.ReadResponse("^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
-		if (status == 0) return RET_ERR(false, E_UNKNOWN);
-		if (status == 1 || status == 5) break;
-
-		if (sw.ElapsedMilliseconds() >= (unsigned long)timeout) return RET_ERR(false, E_UNKNOWN);
+		if (registration->Status == 0) return false;	// Not searching.
+		if (registration->Status == 1 || registration->Status == 5) break;
+
+		unsigned long elapsed = sw.ElapsedMilliseconds();
+		if (elapsed >= (unsigned long)timeout) return false;
+		if (fallback.ElapsedMilliseconds() >= REGISTRATION_FALLBACK_INTERVAL) {
+			if (!QueryRegistration(ps)) return false;
+			fallback.Restart();
+			continue;
+		}
+		unsigned long wait = REGISTRATION_FALLBACK_INTERVAL - fallback.ElapsedMilliseconds();
+		if (wait > timeout - elapsed) wait = timeout - elapsed;
+		_AtSerial.ReadUnsolicitedResponse(wait);
 	}
 
 	// for debug.
@@ -390,40 +869,39 @@ bool Wio3G::WaitForCSRegistration(long timeout)
 	DEBUG_PRINTLN(str);
 #endif // WIO_DEBUG
 
+	return true;
+}
+
+bool Wio3G::WaitForCSRegistration(long timeout)
+{
+	if (!WaitForRegistration(false, timeout)) return RET_ERR(false, E_UNKNOWN);
+
 	return RET_OK(true);
 }
 
 bool Wio3G::WaitForPSRegistration(long timeout)
 {
-	std::string response;
-	ArgumentParser parser;
-
-	Stopwatch sw;
-	sw.Restart();
-	while (true) {
-		int status;
+	if (!WaitForRegistration(true, timeout)) return RET_ERR(false, E_UNKNOWN);
 
-		_AtSerial.WriteCommand("AT+CGREG?");
-		if (!_AtSerial.ReadResponse("^\\+CGREG: (.*)$", 500, &response)) return RET_ERR(false, E_UNKNOWN);
-		parser.Parse(response.c_str());
-		if (parser.Size() < 2) return RET_ERR(false, E_UNKNOWN);
-		//resultCode = atoi(parser[0]);
-		status = atoi(parser[1]);
-		if (!_AtSerial.ReadResponse("^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
-		if (status == 0) return RET_ERR(false, E_UNKNOWN);
-		if (status == 1 || status == 5) break;
+	return RET_OK(true);
+}
 
-		if (sw.ElapsedMilliseconds() >= (unsigned long)timeout) return RET_ERR(false, E_UNKNOWN);
-	}
+//! Get the circuit switched registration cached from +CREG.
+void Wio3G::GetCSRegistration(RegistrationStatus* status) const
+{
+	*status = _CSRegistration;
+}
 
-	// for debug.
-#ifdef WIO_DEBUG
-	char str[100];
-	sprintf(str, "Elapsed time is %lu[msec.].", sw.ElapsedMilliseconds());
-	DEBUG_PRINTLN(str);
-#endif // WIO_DEBUG
+//! Get the packet switched registration cached from +CGREG.
+void Wio3G::GetPSRegistration(RegistrationStatus* status) const
+{
+	*status = _PSRegistration;
+}
 
-	return RET_OK(true);
+//! Get the time taken to reach each phase of boot and attach since the module was powered.
+void Wio3G::GetPhaseTimes(PhaseTimes* times) const
+{
+	*times = _PhaseTimes;
 }
 
 bool Wio3G::Activate(const char* accessPointName, const char* userName, const char* password, long waitForRegistTimeout)
@@ -435,28 +913,30 @@ bool Wio3G::Activate(const char* accessPointName, const char* userName, const ch
 
 	// for debug.
 #ifdef WIO_DEBUG
-	_AtSerial.WriteCommandAndReadResponse("AT+CREG?", "^OK$", 500, NULL);
-	_AtSerial.WriteCommandAndReadResponse("AT+CGREG?", "^OK$", 500, NULL);
+	_AtSerial.WriteCommandAndReadResponse("AT+CREG?", PatternOk, 500, NULL);
+	_AtSerial.WriteCommandAndReadResponse("AT+CGREG?", PatternOk, 500, NULL);
 #endif // WIO_DEBUG
 
 	StringBuilder str;
 	if (!str.WriteFormat("AT+QICSGP=1,1,\"%s\",\"%s\",\"%s\",1", accessPointName, userName, password)) return RET_ERR(false, E_UNKNOWN);
-	if (!_AtSerial.WriteCommandAndReadResponse(str.GetString(), "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+	if (!_AtSerial.WriteCommandAndReadResponse(str.GetString(), PatternOk, 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+	PhaseMark(&_PhaseTimes.ContextConfigured);
 
 	Stopwatch sw;
 	sw.Restart();
 	while (true) {
 		_AtSerial.WriteCommand("AT+QIACT=1");
-		if (!_AtSerial.ReadResponse("^(OK|ERROR)$", 150000, &response)) return RET_ERR(false, E_UNKNOWN);
+		if (!_AtSerial.ReadResponse(PatternOkOrError, ACTIVATE_TIMEOUT, &response)) return RET_ERR(false, E_UNKNOWN);
 		if (response == "OK") break;
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QIGETERROR", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
-		if (sw.ElapsedMilliseconds() >= 150000) return RET_ERR(false, E_UNKNOWN);
+		if (!_AtSerial.WriteCommandAndReadResponse("AT+QIGETERROR", PatternOk, 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+		if (sw.ElapsedMilliseconds() >= ACTIVATE_TIMEOUT) return RET_ERR(false, E_UNKNOWN);
 		delay(POLLING_INTERVAL);
 	}
+	PhaseMark(&_PhaseTimes.Activated);
 
 	// for debug.
 #ifdef WIO_DEBUG
-	if (!_AtSerial.WriteCommandAndReadResponse("AT+QIACT?", "^OK$", 150000, NULL)) return RET_ERR(false, E_UNKNOWN);
+	if (!_AtSerial.WriteCommandAndReadResponse("AT+QIACT?", PatternOk, 150000, NULL)) return RET_ERR(false, E_UNKNOWN);
 #endif // WIO_DEBUG
 
 	return RET_OK(true);
@@ -464,18 +944,38 @@ bool Wio3G::Activate(const char* accessPointName, const char* userName, const ch
 
 bool Wio3G::Deactivate()
 {
-	if (!_AtSerial.WriteCommandAndReadResponse("AT+QIDEACT=1", "^OK$", 40000, NULL)) return RET_ERR(false, E_UNKNOWN);
+	if (!_AtSerial.WriteCommandAndReadResponse("AT+QIDEACT=1", PatternOk, 40000, NULL)) return RET_ERR(false, E_UNKNOWN);
 
 	return RET_OK(true);
 }
 
-int Wio3G::SocketOpen(const char* host, int port, SocketType type)
+// Read the connectIds in use from the module. Only needed when the local bitmap may be stale.
+bool Wio3G::SyncConnectIdUsed()
 {
-	std::string response;
-	ArgumentParser parser;
+	const char* response;
+	int responseLength;
+
+	_ConnectIdUsed = 0;
+
+	_AtSerial.WriteCommand("AT+QISTATE?");
+	while (true) {
+		if (!_AtSerial.ReadResponse("^(OK|\\+QISTATE: .*)$", 10000, &response, &responseLength)) return false;
+		if (strcmp(response, "OK") == 0) break;
 
-	if (host == NULL || host[0] == '\0') return RET_ERR(-1, E_UNKNOWN);
-	if (port < 0 || 65535 < port) return RET_ERR(-1, E_UNKNOWN);
+		int connectId = atoi(&response[10]);
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId) return false;
+		_ConnectIdUsed |= 1 << connectId;
+	}
+	_ConnectIdSynced = true;
+
+	return true;
+}
+
+// Validate the arguments, pick a free connectId and write AT+QIOPEN. Returns the connectId or -1.
+int Wio3G::SocketOpenRequest(const char* host, int port, SocketType type)
+{
+	if (host == NULL || host[0] == '\0') return -1;
+	if (port < 0 || 65535 < port) return -1;
 
 	const char* typeStr;
 	switch (type) {
@@ -486,52 +986,68 @@ int Wio3G::SocketOpen(const char* host, int port, SocketType type)
 		typeStr = "UDP";
 		break;
 	default:
-		return RET_ERR(-1, E_UNKNOWN);
+		return -1;
 	}
 
-	bool connectIdUsed[CONNECT_ID_NUM];
-	for (int i = 0; i < CONNECT_ID_NUM; i++) connectIdUsed[i] = false;
-
-	_AtSerial.WriteCommand("AT+QISTATE?");
-	do {
-		if (!_AtSerial.ReadResponse("^(OK|\\+QISTATE: .*)$", 10000, &response)) return RET_ERR(-1, E_UNKNOWN);
-		if (strncmp(response.c_str(), "+QISTATE: ", 10) == 0) {
-			parser.Parse(&response.c_str()[10]);
-			if (parser.Size() >= 1) {
-				int connectId = atoi(parser[0]);
-				if (connectId < 0 || CONNECT_ID_NUM <= connectId) return RET_ERR(-1, E_UNKNOWN);
-				connectIdUsed[connectId] = true;
-			}
-		}
-	} while (response != "OK");
+	if (!_ConnectIdSynced) {
+		if (!SyncConnectIdUsed()) return -1;
+	}
 
 	int connectId;
 	for (connectId = 0; connectId < CONNECT_ID_NUM; connectId++) {
-		if (!connectIdUsed[connectId]) break;
+		if (!(_ConnectIdUsed & (1 << connectId))) break;
 	}
-	if (connectId >= CONNECT_ID_NUM) return RET_ERR(-1, E_UNKNOWN);
+	if (connectId >= CONNECT_ID_NUM) return -1;
 
 	StringBuilder str;
-	if (!str.WriteFormat("AT+QIOPEN=1,%d,\"%s\",\"%s\",%d", connectId, typeStr, host, port)) return RET_ERR(-1, E_UNKNOWN);
-	if (!_AtSerial.WriteCommandAndReadResponse(str.GetString(), "^OK$", 150000, NULL)) return RET_ERR(-1, E_UNKNOWN);
-	str.Clear();
-	if (!str.WriteFormat("^\\+QIOPEN: %d,0$", connectId)) return RET_ERR(-1, E_UNKNOWN);
-	if (!_AtSerial.ReadResponse(str.GetString(), 150000, NULL)) return RET_ERR(-1, E_UNKNOWN);
+	if (!str.WriteFormat("AT+QIOPEN=1,%d,\"%s\",\"%s\",%d", connectId, typeStr, host, port)) return -1;
+	// On failure the module may or may not hold the connectId, so resync before the next open.
+	_ConnectIdSynced = false;
+	_AtSerial.WriteCommand(str.GetString());
+
+	return connectId;
+}
+
+// Bookkeeping after +QIOPEN: <connectId>,0.
+void Wio3G::SocketOpened(int connectId)
+{
+	_ConnectIdUsed |= 1 << connectId;
+	_ConnectIdSynced = true;
+
+	_SocketReadable |= 1 << connectId;	// Data may arrive before the first read.
+	_SocketClosed &= ~(1 << connectId);
+
+	PhaseMark(&_PhaseTimes.FirstSocketOpened);
+}
+
+int Wio3G::SocketOpen(const char* host, int port, SocketType type)
+{
+	int connectId = SocketOpenRequest(host, port, type);
+	if (connectId < 0) return RET_ERR(-1, E_UNKNOWN);
+	if (!_AtSerial.ReadResponse(PatternOk, SOCKET_OPEN_TIMEOUT, NULL)) return RET_ERR(-1, E_UNKNOWN);
+
+	char pattern[40];
+	snprintf(pattern, sizeof (pattern), "^\\+QIOPEN: %d,([0-9]+)$", connectId);
+	const char* parameter;
+	int parameterLength;
+	if (!_AtSerial.ReadResponse(pattern, SOCKET_OPEN_TIMEOUT, &parameter, &parameterLength)) return RET_ERR(-1, E_UNKNOWN);
+	if (atoi(parameter) != 0) return RET_ERR(-1, E_UNKNOWN);
+	SocketOpened(connectId);
 
 	return RET_OK(connectId);
 }
 
 bool Wio3G::SocketSend(int connectId, const byte* data, int dataSize)
 {
-	if (connectId >= CONNECT_ID_NUM) return RET_ERR(false, E_UNKNOWN);
-	if (dataSize > 1460) return RET_ERR(false, E_UNKNOWN);
+	if (connectId < 0 || CONNECT_ID_NUM <= connectId) return RET_ERR(false, E_UNKNOWN);
+	if (dataSize < 0 || SOCKET_SEND_MAX_LENGTH < dataSize) return RET_ERR(false, E_UNKNOWN);
 
-	StringBuilder str;
-	if (!str.WriteFormat("AT+QISEND=%d,%d", connectId, dataSize)) return RET_ERR(false, E_UNKNOWN);
-	_AtSerial.WriteCommand(str.GetString());
-	if (!_AtSerial.ReadResponse("^>", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+	char str[40];
+	snprintf(str, sizeof (str), "AT+QISEND=%d,%d", connectId, dataSize);
+	_AtSerial.WriteCommand(str);
+	if (!_AtSerial.ReadResponse(PatternPrompt, 500, NULL)) return RET_ERR(false, E_UNKNOWN);
 	_AtSerial.WriteBinary(data, dataSize);
-	if (!_AtSerial.ReadResponse("^SEND OK$", 5000, NULL)) return RET_ERR(false, E_UNKNOWN);
+	if (!_AtSerial.ReadResponse(PatternSendOk, 5000, NULL)) return RET_ERR(false, E_UNKNOWN);
 
 	return RET_OK(true);
 }
@@ -541,28 +1057,147 @@ bool Wio3G::SocketSend(int connectId, const char* data)
 	return SocketSend(connectId, (const byte*)data, strlen(data));
 }
 
-int Wio3G::SocketReceive(int connectId, byte* data, int dataSize)
+bool Wio3G::SocketGetUnackedSize(int connectId, int* unackedSize)
 {
-	std::string response;
+	const char* parameter;
+	int parameterLength;
 
-	if (connectId >= CONNECT_ID_NUM) return RET_ERR(-1, E_UNKNOWN);
+	char str[40];
+	snprintf(str, sizeof (str), "AT+QISEND=%d,0", connectId);
+	_AtSerial.WriteCommand(str);
+	if (!_AtSerial.ReadResponse(PatternQisendQuery, 500, &parameter, &parameterLength)) return false;
+	*unackedSize = atoi(parameter);
+	if (!_AtSerial.ReadResponse(PatternOk, 500, NULL)) return false;
 
-	StringBuilder str;
-	if (!str.WriteFormat("AT+QIRD=%d", connectId)) return RET_ERR(-1, E_UNKNOWN);
-	_AtSerial.WriteCommand(str.GetString());
-	if (!_AtSerial.ReadResponse("^\\+QIRD: (.*)$", 500, &response)) return RET_ERR(-1, E_UNKNOWN);
-	int dataLength = atoi(response.c_str());
-	if (dataLength >= 1) {
-		if (dataLength > dataSize) return RET_ERR(-1, E_UNKNOWN);
-		if (!_AtSerial.ReadBinary(data, dataLength, 500)) return RET_ERR(-1, E_UNKNOWN);
-	}
-	if (!_AtSerial.ReadResponse("^OK$", 500, NULL)) return RET_ERR(-1, E_UNKNOWN);
+	return true;
+}
+
+bool Wio3G::WaitForSendWindow(int connectId, int segmentSize, int* unackedSize, SocketSendStatistics* statistics)
+{
+	Stopwatch sw;
+	sw.Restart();
+	while (*unackedSize + segmentSize > SOCKET_SEND_WINDOW) {
+		if (!SocketGetUnackedSize(connectId, unackedSize)) return false;
+		statistics->WindowQueries++;
+		if (*unackedSize + segmentSize <= SOCKET_SEND_WINDOW) break;
+
+		if (SocketClosed(connectId)) return false;
+		if (sw.ElapsedMilliseconds() >= SOCKET_SEND_ACK_TIMEOUT) return false;
+		_AtSerial.ReadUnsolicitedResponse(POLLING_INTERVAL);
+	}
+
+	return true;
+}
+
+// Send in segments of up to SOCKET_SEND_MAX_LENGTH bytes, keeping up to SOCKET_SEND_WINDOW bytes unacknowledged.
+// The unacknowledged size is counted locally and only queried from the module when the window looks full.
+int Wio3G::SocketSendStreamInternal(int connectId, const byte* data, int dataSize, DataProducer producer, void* context, SocketSendStatistics* statistics)
+{
+	if (connectId < 0 || CONNECT_ID_NUM <= connectId) return RET_ERR(-1, E_UNKNOWN);
+
+	SocketSendStatistics localStatistics;
+	if (statistics == NULL) statistics = &localStatistics;
+	memset(statistics, 0, sizeof (*statistics));
+
+	byte segment[SOCKET_SEND_MAX_LENGTH];
+	bool end = false;
+	int sentSize = 0;
+	int unackedSize = 0;
+
+	Stopwatch sw;
+	sw.Restart();
+	while (!end) {
+		const byte* segmentData;
+		int segmentSize;
+		if (producer == NULL) {
+			segmentData = &data[sentSize];
+			segmentSize = dataSize - sentSize < SOCKET_SEND_MAX_LENGTH ? dataSize - sentSize : SOCKET_SEND_MAX_LENGTH;
+			end = sentSize + segmentSize >= dataSize;
+		}
+		else {
+			segmentData = segment;
+			segmentSize = 0;
+			while (segmentSize < SOCKET_SEND_MAX_LENGTH) {
+				int produceSize = producer(&segment[segmentSize], SOCKET_SEND_MAX_LENGTH - segmentSize, context);
+				if (produceSize < 0) return RET_ERR(-1, E_UNKNOWN);
+				if (produceSize == 0) {
+					end = true;
+					break;
+				}
+				segmentSize += produceSize;
+			}
+		}
+		if (segmentSize <= 0) break;
+
+		if (!WaitForSendWindow(connectId, segmentSize, &unackedSize, statistics)) return RET_ERR(-1, E_UNKNOWN);
+		if (!SocketSend(connectId, segmentData, segmentSize)) return RET_ERR(-1, E_UNKNOWN);
+		unackedSize += segmentSize;
+		sentSize += segmentSize;
+
+		statistics->Bytes += segmentSize;
+		statistics->Segments++;
+	}
+	statistics->ElapsedTime = sw.ElapsedMilliseconds();
+	statistics->BytesPerSecond = statistics->ElapsedTime >= 1 ? (unsigned long)((unsigned long long)statistics->Bytes * 1000 / statistics->ElapsedTime) : 0;
+
+	return RET_OK(sentSize);
+}
+
+//! Send data of any size over a TCP socket.
+/*!
+  \param statistics optional. Receives the number of bytes, segments and elapsed time.
+  \return the number of bytes sent, or -1 on error.
+*/
+int Wio3G::SocketSendStream(int connectId, const byte* data, int dataSize, SocketSendStatistics* statistics)
+{
+	if (data == NULL || dataSize < 0) return RET_ERR(-1, E_UNKNOWN);
+
+	return SocketSendStreamInternal(connectId, data, dataSize, NULL, NULL, statistics);
+}
+
+//! Send data pulled from a producer over a TCP socket until the producer returns 0.
+int Wio3G::SocketSendStream(int connectId, DataProducer producer, void* context, SocketSendStatistics* statistics)
+{
+	if (producer == NULL) return RET_ERR(-1, E_UNKNOWN);
+
+	return SocketSendStreamInternal(connectId, NULL, 0, producer, context, statistics);
+}
+
+int Wio3G::SocketReceive(int connectId, byte* data, int dataSize)
+{
+	const char* parameter;
+	int parameterLength;
+
+	if (connectId < 0 || CONNECT_ID_NUM <= connectId) return RET_ERR(-1, E_UNKNOWN);
+	if (dataSize <= 0) return RET_ERR(-1, E_UNKNOWN);	// AT+QIRD=<id>,0 is a query, not a read.
+
+	// Clear before the command so that a "recv" URC arriving meanwhile is not lost.
+	_SocketReadable &= ~(1 << connectId);
+
+	char str[40];
+	snprintf(str, sizeof (str), "AT+QIRD=%d,%d", connectId, dataSize < SOCKET_RECEIVE_MAX_LENGTH ? dataSize : SOCKET_RECEIVE_MAX_LENGTH);
+	_AtSerial.WriteCommand(str);
+	if (!_AtSerial.ReadResponse(PatternQird, 500, &parameter, &parameterLength)) return RET_ERR(-1, E_UNKNOWN);
+	int dataLength = atoi(parameter);
+	if (dataLength >= 1) {
+		if (dataLength > dataSize) return RET_ERR(-1, E_UNKNOWN);
+		if (!_AtSerial.ReadBinary(data, dataLength, 500)) return RET_ERR(-1, E_UNKNOWN);
+	}
+	if (!_AtSerial.ReadResponse(PatternOk, 500, NULL)) return RET_ERR(-1, E_UNKNOWN);
+
+	if (dataLength >= 1) _SocketReadable |= 1 << connectId;	// More may be buffered.
 
 	return RET_OK(dataLength);
 }
 
 int Wio3G::SocketReceive(int connectId, char* data, int dataSize)
 {
+	if (dataSize == 1) {	// Room for the terminator only.
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId) return RET_ERR(-1, E_UNKNOWN);
+		data[0] = '\0';
+		return RET_OK(0);
+	}
+
 	int dataLength = SocketReceive(connectId, (byte*)data, dataSize - 1);
 	if (dataLength >= 0) data[dataLength] = '\0';
 
@@ -571,135 +1206,271 @@ int Wio3G::SocketReceive(int connectId, char* data, int dataSize)
 
 int Wio3G::SocketReceive(int connectId, byte* data, int dataSize, long timeout)
 {
+	if (connectId < 0 || CONNECT_ID_NUM <= connectId) return RET_ERR(-1, E_UNKNOWN);
+
 	Stopwatch sw;
 	sw.Restart();
+	Stopwatch fallback;
+	fallback.Restart();
 	int dataLength;
 	while ((dataLength = SocketReceive(connectId, data, dataSize)) == 0) {
-		if (sw.ElapsedMilliseconds() >= (unsigned long)timeout) return 0;
-		delay(POLLING_INTERVAL);
+		// Wait for the "recv" URC instead of polling AT+QIRD.
+		// AT+QIRD is still issued at a slow interval in case a URC was missed.
+		while (!SocketReadable(connectId)) {
+			if (SocketClosed(connectId)) return 0;
+			unsigned long elapsed = sw.ElapsedMilliseconds();
+			if (elapsed >= (unsigned long)timeout) return 0;
+			if (fallback.ElapsedMilliseconds() >= URC_FALLBACK_INTERVAL) break;
+			_AtSerial.ReadUnsolicitedResponse(timeout - elapsed < URC_FALLBACK_INTERVAL ? timeout - elapsed : URC_FALLBACK_INTERVAL);
+		}
+		fallback.Restart();
 	}
 	return dataLength;
 }
 
 int Wio3G::SocketReceive(int connectId, char* data, int dataSize, long timeout)
 {
-	Stopwatch sw;
-	sw.Restart();
-	int dataLength;
-	while ((dataLength = SocketReceive(connectId, data, dataSize)) == 0) {
-		if (sw.ElapsedMilliseconds() >= (unsigned long)timeout) return 0;
-		delay(POLLING_INTERVAL);
+	if (dataSize == 1) {	// Room for the terminator only.
+		if (connectId < 0 || CONNECT_ID_NUM <= connectId) return RET_ERR(-1, E_UNKNOWN);
+		data[0] = '\0';
+		return RET_OK(0);
 	}
+
+	int dataLength = SocketReceive(connectId, (byte*)data, dataSize - 1, timeout);
+	if (dataLength >= 0) data[dataLength] = '\0';
+
 	return dataLength;
 }
 
 bool Wio3G::SocketClose(int connectId)
 {
-	if (connectId >= CONNECT_ID_NUM) return RET_ERR(false, E_UNKNOWN);
+	if (connectId < 0 || CONNECT_ID_NUM <= connectId) return RET_ERR(false, E_UNKNOWN);
 
 	StringBuilder str;
 	if (!str.WriteFormat("AT+QICLOSE=%d", connectId)) return RET_ERR(false, E_UNKNOWN);
-	if (!_AtSerial.WriteCommandAndReadResponse(str.GetString(), "^OK$", 10000, NULL)) return RET_ERR(false, E_UNKNOWN);
+	if (!_AtSerial.WriteCommandAndReadResponse(str.GetString(), PatternOk, 10000, NULL)) {
+		_ConnectIdSynced = false;
+		return RET_ERR(false, E_UNKNOWN);
+	}
+
+	_ConnectIdUsed &= ~(1 << connectId);
+	_SocketReadable &= ~(1 << connectId);
+	_SocketClosed &= ~(1 << connectId);
 
 	return RET_OK(true);
 }
 
-int Wio3G::HttpGet(const char* url, char* data, int dataSize)
+bool Wio3G::SocketReadable(int connectId) const
 {
-	std::string response;
-	ArgumentParser parser;
+	if (connectId < 0 || CONNECT_ID_NUM <= connectId) return false;
+
+	return _SocketReadable & (1 << connectId) ? true : false;
+}
+
+bool Wio3G::SocketClosed(int connectId) const
+{
+	if (connectId < 0 || CONNECT_ID_NUM <= connectId) return false;
+
+	return _SocketClosed & (1 << connectId) ? true : false;
+}
+
+//! Process the responses that have already arrived, without blocking.
+/*!
+  Dispatches unsolicited result codes and advances the asynchronous operation started by ActivateAsync, SocketOpenAsync or HttpGetAsync.
+  Call it from loop().
+*/
+void Wio3G::Poll()
+{
+	const char* response;
+	int responseLength;
+	while (true) {
+		// The body of AT+QHTTPREAD is not split into lines.
+		if (_Async.State == ASYNC_STATE_HTTP_GET_READ && !AsyncHttpGetRead()) break;
 
-	if (strncmp(url, "https:", 6) == 0) {
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QHTTPCFG=\"sslctxid\",1", "^OK$", 500, NULL)) return RET_ERR(-1, E_UNKNOWN);
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"sslversion\",1,4", "^OK$", 500, NULL)) return RET_ERR(-1, E_UNKNOWN);
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"ciphersuite\",1,\"0XFFFF\"", "^OK$", 500, NULL)) return RET_ERR(-1, E_UNKNOWN);
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"seclevel\",1,0", "^OK$", 500, NULL)) return RET_ERR(-1, E_UNKNOWN);
+		if (!_AtSerial.PollResponse(&response, &responseLength)) break;
+		if (ReadResponseCallback(response)) continue;
+		if (_Async.State != ASYNC_STATE_NONE) AsyncOnResponse(response);
 	}
 
-	if (!_AtSerial.WriteCommandAndReadResponse("AT+QHTTPCFG=\"requestheader\",0", "^OK$", 500, NULL)) return RET_ERR(-1, E_UNKNOWN);
+	if (_Async.State == ASYNC_STATE_ACTIVATE_WAIT_REGIST) AsyncOnRegistration();
+
+	if (_Async.State != ASYNC_STATE_NONE && _Async.StepStopwatch.ElapsedMilliseconds() >= _Async.StepTimeout) AsyncOnStepTimeout();
+}
+
+//! Set a function called when a socket URC is received.
+/*!
+  The callback runs inside the driver while a response is being read. Do not call Wio3G functions from it.
+*/
+void Wio3G::SetSocketEventCallback(SocketEventCallback callback)
+{
+	_SocketEventCallback = callback;
+}
 
-	if (!HttpSetUrl(url)) return RET_ERR(-1, E_UNKNOWN);
+// Configure the HTTP context and set the URL, up to (not including) AT+QHTTPGET.
+bool Wio3G::HttpGetRequest(const char* url)
+{
+	if (!HttpConfig(strncmp(url, "https:", 6) == 0, 0)) return false;
 
-	if (!_AtSerial.WriteCommandAndReadResponse("AT+QHTTPGET", "^OK$", 500, NULL)) return RET_ERR(-1, E_UNKNOWN);
-	if (!_AtSerial.ReadResponse("^\\+QHTTPGET: (.*)$", 60000, &response)) return RET_ERR(-1, E_UNKNOWN);
+	if (!HttpSetUrl(url)) return false;
+
+	return true;
+}
+
+// Send AT+QHTTPGET and wait for +QHTTPGET. *contentLength is -1 if the server did not report it.
+bool Wio3G::HttpGetSend(int* contentLength)
+{
+	std::string response;
+	ArgumentParser parser;
+
+	if (!_AtSerial.WriteCommandAndReadResponse("AT+QHTTPGET", PatternOk, 500, NULL)) return false;
+	if (!_AtSerial.ReadResponse("^\\+QHTTPGET: (.*)$", HTTP_GET_TIMEOUT, &response)) return false;
 
 	parser.Parse(response.c_str());
-	if (parser.Size() < 1) return RET_ERR(-1, E_UNKNOWN);
-	if (strcmp(parser[0], "0") != 0) return RET_ERR(-1, E_UNKNOWN);
-	int contentLength = parser.Size() >= 3 ? atoi(parser[2]) : -1;
+	if (parser.Size() < 1) return false;
+	if (strcmp(parser[0], "0") != 0) return false;
+	*contentLength = parser.Size() >= 3 ? atoi(parser[2]) : -1;
 
+	return true;
+}
+
+// Read the body the module has already downloaded. contentLength is -1 if +QHTTPGET did not report it.
+int Wio3G::HttpGetRead(int contentLength, char* data, int dataSize)
+{
 	_AtSerial.WriteCommand("AT+QHTTPREAD");
-	if (!_AtSerial.ReadResponse("^CONNECT$", 1000, NULL)) return RET_ERR(-1, E_UNKNOWN);
+	if (!_AtSerial.ReadResponse(PatternConnect, 1000, NULL)) return -1;
 	if (contentLength >= 0) {
-		if (contentLength + 1 > dataSize) return RET_ERR(-1, E_UNKNOWN);
-		if (!_AtSerial.ReadBinary((byte*)data, contentLength, 60000)) return RET_ERR(-1, E_UNKNOWN);
+		if (contentLength + 1 > dataSize) return -1;
+		if (!_AtSerial.ReadBinary((byte*)data, contentLength, 60000)) return -1;
 		data[contentLength] = '\0';
 
-		if (!_AtSerial.ReadResponse("^OK$", 1000, NULL)) return RET_ERR(-1, E_UNKNOWN);
+		if (!_AtSerial.ReadResponse(PatternOk, 1000, NULL)) return -1;
 	}
 	else {
-		if (!_AtSerial.ReadResponseQHTTPREAD(data, dataSize, 60000)) return RET_ERR(-1, E_UNKNOWN);
+		if (!_AtSerial.ReadResponseQHTTPREAD(data, dataSize, 60000)) return -1;
 		contentLength = strlen(data);
 	}
-	if (!_AtSerial.ReadResponse("^\\+QHTTPREAD: 0$", 1000, NULL)) return RET_ERR(-1, E_UNKNOWN);
+	if (!_AtSerial.ReadResponse(PatternQhttpreadEnd, 1000, NULL)) return -1;
+
+	return contentLength;
+}
+
+int Wio3G::HttpGet(const char* url, char* data, int dataSize)
+{
+	if (!HttpGetRequest(url)) return RET_ERR(-1, E_UNKNOWN);
+
+	int contentLength;
+	if (!HttpGetSend(&contentLength)) return RET_ERR(-1, E_UNKNOWN);
+
+	contentLength = HttpGetRead(contentLength, data, dataSize);
+	if (contentLength < 0) return RET_ERR(-1, E_UNKNOWN);
 
 	return RET_OK(contentLength);
 }
 
-bool Wio3G::HttpPost(const char* url, const char* data, int* responseCode)
+//! Get the body of url and pass it to consumer as it arrives.
+/*!
+  The body does not have to fit in memory. It is passed in chunks of up to 256 bytes.
+  \param consumer a function that receives the body. If it returns false, the rest of the body is discarded and HttpGet fails.
+  \param context passed to consumer as is.
+  \return the body length in bytes, or -1 on failure.
+*/
+int Wio3G::HttpGet(const char* url, DataConsumer consumer, void* context)
 {
-	std::string response;
-	ArgumentParser parser;
+	if (!HttpGetRequest(url)) return RET_ERR(-1, E_UNKNOWN);
+
+	int contentLength;
+	if (!HttpGetSend(&contentLength)) return RET_ERR(-1, E_UNKNOWN);
 
-	if (strncmp(url, "https:", 6) == 0) {
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QHTTPCFG=\"sslctxid\",1", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"sslversion\",1,4", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"ciphersuite\",1,\"0XFFFF\"", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
-		if (!_AtSerial.WriteCommandAndReadResponse("AT+QSSLCFG=\"seclevel\",1,0", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+	_AtSerial.WriteCommand("AT+QHTTPREAD");
+	if (!_AtSerial.ReadResponse(PatternConnect, 1000, NULL)) return RET_ERR(-1, E_UNKNOWN);
+	bool stopped;
+	if (contentLength >= 0) {
+		if (!_AtSerial.ReadBinary(contentLength, consumer, context, 60000, &stopped)) return RET_ERR(-1, E_UNKNOWN);
+		if (!_AtSerial.ReadResponse(PatternOk, 1000, NULL)) return RET_ERR(-1, E_UNKNOWN);
 	}
+	else {
+		// Without Content-Length the body ends at the OK line. The module has no bounded AT+QHTTPREAD, so the terminator is searched on the fly.
+		contentLength = _AtSerial.ReadBinaryUntil("\r\nOK\r\n", consumer, context, 60000, &stopped);
+		if (contentLength < 0) return RET_ERR(-1, E_UNKNOWN);
+	}
+	if (!_AtSerial.ReadResponse(PatternQhttpreadEnd, 1000, NULL)) return RET_ERR(-1, E_UNKNOWN);
+	if (stopped) return RET_ERR(-1, E_UNKNOWN);
+
+	return RET_OK(contentLength);
+}
 
-	if (!_AtSerial.WriteCommandAndReadResponse("AT+QHTTPCFG=\"requestheader\",1", "^OK$", 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+// Write an HTTP POST request (header, then body from data or producer) straight to the module. Nothing is buffered except one chunk of the body.
+bool Wio3G::HttpPostInternal(const char* url, const byte* data, DataProducer producer, void* context, int dataSize, const char* contentType, const char* headers, int* responseCode)
+{
+	std::string response;
+	ArgumentParser parser;
 
-	if (!HttpSetUrl(url)) return RET_ERR(false, E_UNKNOWN);
+	if (dataSize < 0) return false;
+	if (contentType == NULL) contentType = HTTP_POST_CONTENT_TYPE;
+	if (headers == NULL) headers = "";
 
 	const char* host;
 	int hostLength;
 	const char* uri;
 	int uriLength;
-	if (!SplitUrl(url, &host, &hostLength, &uri, &uriLength)) return RET_ERR(false, E_UNKNOWN);
-
-
-	StringBuilder header;
-	header.Write("POST ");
+	if (!SplitUrl(url, &host, &hostLength, &uri, &uriLength)) return false;
 	if (uriLength <= 0) {
-		header.Write("/");
+		uri = "/";
+		uriLength = 1;
+	}
+	const char* userAgent = HasHttpHeader(headers, "User-Agent") ? "" : "User-Agent: " HTTP_POST_USER_AGENT "\r\n";
+	char contentLength[40];
+	sprintf(contentLength, "Content-Length: %d\r\n\r\n", dataSize);
+
+	int headerLength =
+		strlen(HTTP_POST_HEADER_1) + uriLength + strlen(HTTP_POST_HEADER_2) + hostLength + strlen(HTTP_POST_HEADER_3) +
+		strlen(userAgent) + strlen(HTTP_POST_HEADER_4) + strlen(contentType) + strlen(HTTP_POST_HEADER_5) + strlen(headers) + strlen(contentLength);
+
+	if (!HttpConfig(strncmp(url, "https:", 6) == 0, 1)) return false;
+
+	if (!HttpSetUrl(url)) return false;
+
+	char str[40];
+	snprintf(str, sizeof (str), "AT+QHTTPPOST=%d,%d,%d", headerLength + dataSize, HTTP_POST_INPUT_TIME, HTTP_POST_RESPONSE_TIME);
+	_AtSerial.WriteCommand(str);
+	if (!_AtSerial.ReadResponse(PatternConnect, 60000, NULL)) return false;
+	_AtSerial.WriteBinary((const byte*)HTTP_POST_HEADER_1, strlen(HTTP_POST_HEADER_1));
+	_AtSerial.WriteBinary((const byte*)uri, uriLength);
+	_AtSerial.WriteBinary((const byte*)HTTP_POST_HEADER_2, strlen(HTTP_POST_HEADER_2));
+	_AtSerial.WriteBinary((const byte*)host, hostLength);
+	_AtSerial.WriteBinary((const byte*)HTTP_POST_HEADER_3, strlen(HTTP_POST_HEADER_3));
+	_AtSerial.WriteBinary((const byte*)userAgent, strlen(userAgent));
+	_AtSerial.WriteBinary((const byte*)HTTP_POST_HEADER_4, strlen(HTTP_POST_HEADER_4));
+	_AtSerial.WriteBinary((const byte*)contentType, strlen(contentType));
+	_AtSerial.WriteBinary((const byte*)HTTP_POST_HEADER_5, strlen(HTTP_POST_HEADER_5));
+	_AtSerial.WriteBinary((const byte*)headers, strlen(headers));
+	_AtSerial.WriteBinary((const byte*)contentLength, strlen(contentLength));
+
+	if (producer == NULL) {
+		_AtSerial.WriteBinary(data, dataSize);
 	}
 	else {
-		header.Write(uri, uriLength);
-	}
-	header.Write(" HTTP/1.1\r\n");
-	header.Write("Host: ");
-	header.Write(host, hostLength);
-	header.Write("\r\n");
-	header.Write("Accept: */*\r\n");
-	header.Write("User-Agent: " HTTP_POST_USER_AGENT "\r\n");
-	header.Write("Connection: Keep-Alive\r\n");
-	header.Write("Content-Type: " HTTP_POST_CONTENT_TYPE "\r\n");
-	if (!header.WriteFormat("Content-Length: %d\r\n", strlen(data))) return RET_ERR(false, E_UNKNOWN);
-	header.Write("\r\n");
+		byte chunk[HTTP_POST_CHUNK_SIZE];
+		int remain = dataSize;
+		while (remain > 0) {
+			int chunkSize = remain < HTTP_POST_CHUNK_SIZE ? remain : HTTP_POST_CHUNK_SIZE;
+			int producedSize = producer(chunk, chunkSize, context);
+			if (producedSize <= 0 || producedSize > chunkSize) {
+				// The module sends nothing until it has all the bytes, so stop here and let it give up the request at the input time.
+				DEBUG_PRINTLN("### PRODUCER SHORT ###");
+				_AtSerial.ReadResponse("^(OK|ERROR|\\+CME ERROR: .*)$", HTTP_POST_INPUT_TIME * 1000UL + 5000, NULL);
+				return false;
+			}
+			_AtSerial.WriteBinary(chunk, producedSize);
+			remain -= producedSize;
+		}
+	}
 
-	StringBuilder str;
-	if (!str.WriteFormat("AT+QHTTPPOST=%d", header.Length() + strlen(data))) return RET_ERR(false, E_UNKNOWN);
-	_AtSerial.WriteCommand(str.GetString());
-	if (!_AtSerial.ReadResponse("^CONNECT$", 60000, NULL)) return RET_ERR(false, E_UNKNOWN);
-	const char* headerStr = header.GetString();
-	_AtSerial.WriteBinary((const byte*)headerStr, strlen(headerStr));
-	_AtSerial.WriteBinary((const byte*)data, strlen(data));
-	if (!_AtSerial.ReadResponse("^OK$", 1000, NULL)) return RET_ERR(false, E_UNKNOWN);
-	if (!_AtSerial.ReadResponse("^\\+QHTTPPOST: (.*)$", 60000, &response)) return RET_ERR(false, E_UNKNOWN);
+	if (!_AtSerial.ReadResponse(PatternOk, 1000, NULL)) return false;
+	if (!_AtSerial.ReadResponse("^\\+QHTTPPOST: (.*)$", HTTP_POST_RESPONSE_TIME * 1000UL, &response)) return false;
 	parser.Parse(response.c_str());
-	if (parser.Size() < 1) return RET_ERR(false, E_UNKNOWN);
-	if (strcmp(parser[0], "0") != 0) return RET_ERR(false, E_UNKNOWN);
+	if (parser.Size() < 1) return false;
+	if (strcmp(parser[0], "0") != 0) return false;
 	if (parser.Size() < 2) {
 		*responseCode = -1;
 	}
@@ -707,6 +1478,43 @@ bool Wio3G::HttpPost(const char* url, const char* data, int* responseCode)
 		*responseCode = atoi(parser[1]);
 	}
 
+	return true;
+}
+
+bool Wio3G::HttpPost(const char* url, const char* data, int* responseCode)
+{
+	if (!HttpPostInternal(url, (const byte*)data, NULL, NULL, strlen(data), NULL, NULL, responseCode)) return RET_ERR(false, E_UNKNOWN);
+
+	return RET_OK(true);
+}
+
+//! Send an HTTP POST request with a binary body.
+/*!
+  The header and body are written directly to the module without being copied.
+  \param contentType the value of Content-Type. NULL means "application/json".
+  \param headers additional header lines, each terminated by CR LF. Can be NULL.
+	             User-Agent is added only if headers does not contain one.
+*/
+bool Wio3G::HttpPost(const char* url, const byte* data, int dataSize, int* responseCode, const char* contentType, const char* headers)
+{
+	if (!HttpPostInternal(url, data, NULL, NULL, dataSize, contentType, headers, responseCode)) return RET_ERR(false, E_UNKNOWN);
+
+	return RET_OK(true);
+}
+
+//! Send an HTTP POST request with a body generated by producer.
+/*!
+  \param producer a function that fills the body in chunks. It must produce exactly dataSize bytes in total.
+	              If it returns 0 or less before dataSize bytes, the request is not sent. The call returns false once the module gives up the input, after 60 seconds.
+  \param context passed to producer as is.
+  \param dataSize the body length written to Content-Length.
+  \param contentType the value of Content-Type. NULL means "application/json".
+  \param headers additional header lines, each terminated by CR LF. Can be NULL.
+*/
+bool Wio3G::HttpPost(const char* url, DataProducer producer, void* context, int dataSize, int* responseCode, const char* contentType, const char* headers)
+{
+	if (!HttpPostInternal(url, NULL, producer, context, dataSize, contentType, headers, responseCode)) return RET_ERR(false, E_UNKNOWN);
+
 	return RET_OK(true);
 }
 
@@ -745,3 +1553,354 @@ bool Wio3G::SendUSSD(const char* in, char* out, int outSize)
 
 	return RET_OK(true);
 }
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Asynchronous operations
+
+bool Wio3G::AsyncBegin(AsyncCallback callback, AsyncStateType state, unsigned long operationTimeout, unsigned long stepTimeout)
+{
+	if (_Async.Status == ASYNC_BUSY) return false;
+
+	_Async.Status = ASYNC_BUSY;
+	_Async.Result = -1;
+	_Async.Callback = callback;
+	_Async.OperationStopwatch.Restart();
+	_Async.OperationTimeout = operationTimeout;
+	AsyncSetState(state, stepTimeout);
+
+	return true;
+}
+
+void Wio3G::AsyncSetState(AsyncStateType state, unsigned long stepTimeout)
+{
+	_Async.State = state;
+	_Async.StepStopwatch.Restart();
+	_Async.StepTimeout = stepTimeout;
+}
+
+void Wio3G::AsyncWriteCommand(const char* command, AsyncStateType state, unsigned long stepTimeout)
+{
+	_AtSerial.WriteCommand(command);
+	AsyncSetState(state, stepTimeout);
+}
+
+void Wio3G::AsyncComplete(AsyncStatus status, int result)
+{
+	_Async.State = ASYNC_STATE_NONE;
+	_Async.Status = status;
+	_Async.Result = result;
+
+	if (status == ASYNC_SUCCEEDED) {
+		RET_OK(result);
+	}
+	else {
+		RET_ERR(result, E_UNKNOWN);
+	}
+
+	if (_Async.Callback != NULL) _Async.Callback(status, result);
+}
+
+void Wio3G::AsyncOnResponse(const char* response)
+{
+	ArgumentParser parser;
+
+	switch (_Async.State) {
+	case ASYNC_STATE_ACTIVATE_CGREG:
+		if (strncmp(response, "+CGREG: ", 8) == 0) {
+			parser.Parse(&response[8]);
+			_Async.RegistStatus = parser.Size() >= 2 ? atoi(parser[1]) : -1;
+		}
+		else if (strcmp(response, "OK") == 0) {
+			if (_Async.RegistStatus == 1 || _Async.RegistStatus == 5) {
+				AsyncActivateQIACT();
+			}
+			else if (_Async.RegistStatus <= 0 || _Async.OperationStopwatch.ElapsedMilliseconds() >= _Async.OperationTimeout) {
+				AsyncComplete(ASYNC_FAILED, -1);
+			}
+			else {
+				AsyncSetState(ASYNC_STATE_ACTIVATE_WAIT_REGIST, REGISTRATION_FALLBACK_INTERVAL);
+			}
+		}
+		else if (strcmp(response, "ERROR") == 0) {
+			AsyncComplete(ASYNC_FAILED, -1);
+		}
+		break;
+
+	case ASYNC_STATE_ACTIVATE_QIACT:
+		if (strcmp(response, "OK") == 0) {
+			PhaseMark(&_PhaseTimes.Activated);
+			AsyncComplete(ASYNC_SUCCEEDED, 0);
+		}
+		else if (strcmp(response, "ERROR") == 0) {
+			AsyncWriteCommand("AT+QIGETERROR", ASYNC_STATE_ACTIVATE_QIGETERROR, 500);
+		}
+		break;
+
+	case ASYNC_STATE_ACTIVATE_QIGETERROR:
+		if (strncmp(response, "+QIGETERROR: ", 13) == 0) {
+			parser.Parse(&response[13]);
+			if (parser.Size() >= 1) _Async.ActivateError = atoi(parser[0]);
+		}
+		else if (strcmp(response, "OK") == 0) {
+			if (_Async.OperationStopwatch.ElapsedMilliseconds() >= _Async.OperationTimeout) {
+				AsyncComplete(ASYNC_FAILED, _Async.ActivateError);
+			}
+			else {
+				AsyncSetState(ASYNC_STATE_ACTIVATE_WAIT_QIACT, POLLING_INTERVAL);
+			}
+		}
+		break;
+
+	case ASYNC_STATE_SOCKET_OPEN_OK:
+	case ASYNC_STATE_SOCKET_OPEN_URC:
+		if (strcmp(response, "OK") == 0) {
+			AsyncSetState(ASYNC_STATE_SOCKET_OPEN_URC, SOCKET_OPEN_TIMEOUT);
+		}
+		else if (strcmp(response, "ERROR") == 0) {
+			AsyncComplete(ASYNC_FAILED, -1);
+		}
+		else if (strncmp(response, "+QIOPEN: ", 9) == 0) {
+			parser.Parse(&response[9]);
+			if (parser.Size() < 2 || atoi(parser[0]) != _Async.ConnectId) break;
+			if (atoi(parser[1]) != 0) {
+				AsyncComplete(ASYNC_FAILED, -1);
+				break;
+			}
+			SocketOpened(_Async.ConnectId);
+			AsyncComplete(ASYNC_SUCCEEDED, _Async.ConnectId);
+		}
+		break;
+
+	case ASYNC_STATE_HTTP_GET_OK:
+		if (strcmp(response, "OK") == 0) {
+			AsyncSetState(ASYNC_STATE_HTTP_GET_URC, HTTP_GET_TIMEOUT);
+		}
+		else if (strncmp(response, "+CME ERROR: ", 12) == 0 || strcmp(response, "ERROR") == 0) {
+			AsyncComplete(ASYNC_FAILED, -1);
+		}
+		break;
+
+	case ASYNC_STATE_HTTP_GET_URC:
+		if (strncmp(response, "+QHTTPGET: ", 11) == 0) {
+			parser.Parse(&response[11]);
+			if (parser.Size() < 1 || strcmp(parser[0], "0") != 0) {
+				AsyncComplete(ASYNC_FAILED, -1);
+				break;
+			}
+			_Async.ContentLength = parser.Size() >= 3 ? atoi(parser[2]) : -1;
+			_Async.ReadLength = 0;
+			_Async.TerminatorMatch = 0;
+			AsyncWriteCommand("AT+QHTTPREAD", ASYNC_STATE_HTTP_GET_CONNECT, 1000);
+		}
+		break;
+
+	case ASYNC_STATE_HTTP_GET_CONNECT:
+		if (strcmp(response, "CONNECT") == 0) {
+			AsyncSetState(ASYNC_STATE_HTTP_GET_READ, 60000);
+		}
+		else if (strncmp(response, "+CME ERROR: ", 12) == 0 || strcmp(response, "ERROR") == 0) {
+			AsyncComplete(ASYNC_FAILED, -1);
+		}
+		break;
+
+	case ASYNC_STATE_HTTP_GET_READ_END:
+		if (strncmp(response, "+QHTTPREAD: ", 12) == 0) {
+			if (strcmp(&response[12], "0") != 0 || _Async.ContentLength + 1 > _Async.DataSize) {
+				AsyncComplete(ASYNC_FAILED, -1);
+				break;
+			}
+			_Async.Data[_Async.ContentLength] = '\0';
+			AsyncComplete(ASYNC_SUCCEEDED, _Async.ContentLength);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+// Read the part of the body of AT+QHTTPREAD that has already arrived, up to HTTP_GET_POLL_SIZE bytes.
+// Returns true when the body is complete, false when the rest is left for the next Poll().
+// A body that does not fit in data is still read to the end, so the lines after it stay in sync, and fails at +QHTTPREAD.
+bool Wio3G::AsyncHttpGetRead()
+{
+	static const char terminator[] = "\r\nOK\r\n";
+	const int terminatorLength = sizeof (terminator) - 1;
+	byte chunk[64];
+	int pollRemain = HTTP_GET_POLL_SIZE;
+
+	while (true) {
+		int chunkSize;
+		if (_Async.ContentLength >= 0) {
+			if (_Async.ReadLength >= _Async.ContentLength) break;
+			chunkSize = _Async.ContentLength - _Async.ReadLength < (long)sizeof (chunk) ? _Async.ContentLength - _Async.ReadLength : sizeof (chunk);
+		}
+		else {
+			if (_Async.TerminatorMatch >= terminatorLength) {
+				_Async.ContentLength = _Async.ReadLength - terminatorLength;
+				break;
+			}
+			// The terminator cannot end before this many bytes, so nothing after it is read.
+			chunkSize = terminatorLength - _Async.TerminatorMatch;
+		}
+
+		if (pollRemain <= 0) return false;
+		if (chunkSize > pollRemain) chunkSize = pollRemain;
+		chunkSize = _AtSerial.PollBinary(chunk, chunkSize);
+		if (chunkSize <= 0) return false;
+		pollRemain -= chunkSize;
+
+		for (int i = 0; i < chunkSize; i++) {
+			if (_Async.ReadLength < _Async.DataSize) _Async.Data[_Async.ReadLength] = chunk[i];
+			_Async.ReadLength++;
+			if (_Async.ContentLength < 0) {
+				if (chunk[i] == terminator[_Async.TerminatorMatch]) _Async.TerminatorMatch++;
+				else _Async.TerminatorMatch = chunk[i] == '\r' ? 1 : 0;
+			}
+		}
+	}
+
+	AsyncSetState(ASYNC_STATE_HTTP_GET_READ_END, 1000);
+
+	return true;
+}
+
+void Wio3G::AsyncActivateQIACT()
+{
+	_Async.OperationStopwatch.Restart();
+	_Async.OperationTimeout = ACTIVATE_TIMEOUT;
+	AsyncWriteCommand("AT+QIACT=1", ASYNC_STATE_ACTIVATE_QIACT, ACTIVATE_TIMEOUT);
+}
+
+// While waiting for PS registration, follow the cached status that the +CGREG URCs keep up to date.
+// AT+CGREG? is sent again only when the step times out after REGISTRATION_FALLBACK_INTERVAL, in case a URC was missed.
+void Wio3G::AsyncOnRegistration()
+{
+	int status = _PSRegistration.Status;
+	if (status == 1 || status == 5) {
+		AsyncActivateQIACT();
+	}
+	else if (status == 0 || _Async.OperationStopwatch.ElapsedMilliseconds() >= _Async.OperationTimeout) {
+		AsyncComplete(ASYNC_FAILED, -1);
+	}
+}
+
+void Wio3G::AsyncOnStepTimeout()
+{
+	switch (_Async.State) {
+	case ASYNC_STATE_ACTIVATE_WAIT_REGIST:
+		_Async.RegistStatus = -1;
+		AsyncWriteCommand("AT+CGREG?", ASYNC_STATE_ACTIVATE_CGREG, 500);
+		break;
+	case ASYNC_STATE_ACTIVATE_WAIT_QIACT:
+		AsyncWriteCommand("AT+QIACT=1", ASYNC_STATE_ACTIVATE_QIACT, ACTIVATE_TIMEOUT);
+		break;
+	default:
+		DEBUG_PRINTLN("### ASYNC TIMEOUT ###");
+		AsyncComplete(ASYNC_FAILED, -1);
+		break;
+	}
+}
+
+//! Start Activate without blocking.
+/*!
+  AT+QICSGP is sent immediately. Waiting for PS registration and AT+QIACT=1 are driven by Poll().
+  Do not call other Wio3G functions except Poll, GetAsyncStatus and GetAsyncResult until the operation completes.
+  \param callback a function called from Poll() on completion. result is 0 on success. On failure it is the <err> of the last +QIGETERROR after AT+QIACT=1 failed, or -1. Can be NULL.
+  \return false if another asynchronous operation is busy or AT+QICSGP failed.
+*/
+bool Wio3G::ActivateAsync(const char* accessPointName, const char* userName, const char* password, AsyncCallback callback, long waitForRegistTimeout)
+{
+	if (_Async.Status == ASYNC_BUSY) return RET_ERR(false, E_UNKNOWN);
+
+	StringBuilder str;
+	if (!str.WriteFormat("AT+QICSGP=1,1,\"%s\",\"%s\",\"%s\",1", accessPointName, userName, password)) return RET_ERR(false, E_UNKNOWN);
+	if (!_AtSerial.WriteCommandAndReadResponse(str.GetString(), PatternOk, 500, NULL)) return RET_ERR(false, E_UNKNOWN);
+	PhaseMark(&_PhaseTimes.ContextConfigured);
+
+	_Async.RegistStatus = -1;
+	_Async.ActivateError = -1;
+	AsyncBegin(callback, ASYNC_STATE_ACTIVATE_CGREG, waitForRegistTimeout, 500);
+	_AtSerial.WriteCommand("AT+CGREG?");
+
+	return RET_OK(true);
+}
+
+//! Start SocketOpen without blocking.
+/*!
+  The OK and +QIOPEN responses are handled by Poll().
+  Do not call other Wio3G functions except Poll, GetAsyncStatus and GetAsyncResult until the operation completes.
+  \param callback a function called from Poll() on completion. result is the connectId, or -1 on failure. Can be NULL.
+  \return false if another asynchronous operation is busy or AT+QIOPEN could not be sent.
+*/
+bool Wio3G::SocketOpenAsync(const char* host, int port, SocketType type, AsyncCallback callback)
+{
+	if (_Async.Status == ASYNC_BUSY) return RET_ERR(false, E_UNKNOWN);
+
+	int connectId = SocketOpenRequest(host, port, type);
+	if (connectId < 0) return RET_ERR(false, E_UNKNOWN);
+
+	_Async.ConnectId = connectId;
+	AsyncBegin(callback, ASYNC_STATE_SOCKET_OPEN_OK, SOCKET_OPEN_TIMEOUT, SOCKET_OPEN_TIMEOUT);
+
+	return RET_OK(true);
+}
+
+//! Start HttpGet without blocking.
+/*!
+  The configuration is sent immediately. Waiting for +QHTTPGET and reading the body into data are driven by Poll(), which reads only what has arrived.
+  Do not call other Wio3G functions except Poll, GetAsyncStatus and GetAsyncResult until the operation completes.
+  \param data a buffer that must stay valid until the operation completes.
+  \param callback a function called from Poll() on completion. result is the content length, or -1 on failure. Can be NULL.
+  \return false if another asynchronous operation is busy or the request could not be sent.
+*/
+bool Wio3G::HttpGetAsync(const char* url, char* data, int dataSize, AsyncCallback callback)
+{
+	if (_Async.Status == ASYNC_BUSY) return RET_ERR(false, E_UNKNOWN);
+
+	if (!HttpGetRequest(url)) return RET_ERR(false, E_UNKNOWN);
+
+	_Async.Data = data;
+	_Async.DataSize = dataSize;
+	AsyncBegin(callback, ASYNC_STATE_HTTP_GET_OK, HTTP_GET_TIMEOUT, 500);
+	_AtSerial.WriteCommand("AT+QHTTPGET");
+
+	return RET_OK(true);
+}
+
+//! Get the status of the last asynchronous operation.
+Wio3G::AsyncStatus Wio3G::GetAsyncStatus() const
+{
+	return _Async.Status;
+}
+
+//! Get the result of the last completed asynchronous operation.
+int Wio3G::GetAsyncResult() const
+{
+	return _Async.Result;
+}
+
+#ifdef WIO_AT_STATISTICS
+
+//! Get the number of AT command statistics entries.
+int Wio3G::GetAtStatisticsSize() const
+{
+	return AtStatistics::Size();
+}
+
+//! Get the latency histogram of an AT command prefix.
+/*!
+  \param index 0 to GetAtStatisticsSize() - 1.
+  \return NULL if index is out of range.
+*/
+const AtStatistics::Entry* Wio3G::GetAtStatistics(int index) const
+{
+	return AtStatistics::Get(index);
+}
+
+void Wio3G::ClearAtStatistics()
+{
+	AtStatistics::Clear();
+}
+
+#endif // WIO_AT_STATISTICS
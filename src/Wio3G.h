@@ -22,11 +22,144 @@ public:
 		SOCKET_UDP,
 	};
 
+	enum SocketEventType {
+		SOCKET_EVENT_RECEIVE,			// +QIURC: "recv"
+		SOCKET_EVENT_CLOSED,			// +QIURC: "closed"
+		SOCKET_EVENT_PDP_DEACTIVATED,	// +QIURC: "pdpdeact" (connectId is -1)
+	};
+
+	typedef void (*SocketEventCallback)(int connectId, SocketEventType event);
+
+	// Fill data with up to dataSize bytes. Return the number of bytes written, 0 at the end, or negative on error.
+	typedef int (*DataProducer)(byte* data, int dataSize, void* context);
+
+	// Receive the next dataSize bytes. Return false to stop; the rest is read and discarded.
+	typedef bool (*DataConsumer)(const byte* data, int dataSize, void* context);
+
+	struct SocketSendStatistics {
+		unsigned long Bytes;
+		unsigned long Segments;
+		unsigned long WindowQueries;	// AT+QISEND=<id>,0 issued.
+		unsigned long ElapsedTime;		// [msec.]
+		unsigned long BytesPerSecond;
+	};
+
+	enum QueryType {
+		QUERY_IMEI					= 0x01,	// AT+GSN
+		QUERY_IMSI					= 0x02,	// AT+CIMI
+		QUERY_PHONE_NUMBER			= 0x04,	// AT+CNUM
+		QUERY_RECEIVED_SIGNAL_STRENGTH	= 0x08,	// AT+CSQ
+		QUERY_CS_REGISTRATION		= 0x10,	// AT+CREG?
+		QUERY_PS_REGISTRATION		= 0x20,	// AT+CGREG?
+	};
+
+	// Fields not requested or not reported are left empty, INT_MIN (signal strength) or -1 (registration status).
+	struct QueryResult {
+		char IMEI[15 + 1];
+		char IMSI[15 + 1];
+		char PhoneNumber[20 + 1];
+		int ReceivedSignalStrength;	// [dBm] as GetReceivedSignalStrength.
+		int CSRegistrationStatus;	// <stat> of +CREG.
+		int PSRegistrationStatus;	// <stat> of +CGREG.
+	};
+
+	// Network registration from +CREG/+CGREG. Kept up to date by the unsolicited reports.
+	struct RegistrationStatus {
+		int Status;					// <stat>. 1 and 5 are registered. -1 if unknown.
+		long LocationAreaCode;		// <lac>, or -1 if unknown.
+		long CellId;				// <ci>, or -1 if unknown.
+		unsigned long ChangedTime;	// millis() when Status last changed.
+	};
+
+	// Milliseconds from PowerSupplyCellular(true) to each phase of boot and attach. -1 if not reached.
+	// If the power supply was not turned on by PowerSupplyCellular, they are from TurnOnOrReset.
+	struct PhaseTimes {
+		long PowerSupplyOn;
+		long PowerKey;				// PWRKEY or RESET_N pulse done.
+		long FirstResponse;			// RDY or the first AT response.
+		long SimReady;
+		long CSRegistered;
+		long PSRegistered;
+		long ContextConfigured;		// AT+QICSGP done.
+		long Activated;				// AT+QIACT done.
+		long FirstSocketOpened;
+	};
+
+	enum AsyncStatus {
+		ASYNC_IDLE,
+		ASYNC_BUSY,
+		ASYNC_SUCCEEDED,
+		ASYNC_FAILED,
+	};
+
+	// Called repeatedly while waiting for the module. Wio3G() sets Wio3GWaitForInterrupt, which sleeps with WFI until the next interrupt.
+	typedef void (*IdleHook)(void* context);
+
+	// Called from Poll() when an asynchronous operation completes. See each ...Async function for result.
+	typedef void (*AsyncCallback)(AsyncStatus status, int result);
+
 private:
-	SerialAPI _SerialAPI;
+	SerialAPI* _SerialAPI;
 	AtSerial _AtSerial;
 	Wio3GSK6812 _Led;
 	ErrorCodeType _LastErrorCode;
+	unsigned short _SocketReadable;		// Bit per connectId. Set by "recv" URC, cleared when AT+QIRD returns nothing.
+	unsigned short _SocketClosed;		// Bit per connectId. Set by "closed" and "pdpdeact" URC.
+	SocketEventCallback _SocketEventCallback;
+	unsigned short _ConnectIdUsed;		// Bit per connectId allocated on the module. Cleared by SocketClose only.
+	bool _ConnectIdSynced;				// _ConnectIdUsed is known to match the module.
+
+	enum AsyncStateType {
+		ASYNC_STATE_NONE,
+		ASYNC_STATE_ACTIVATE_WAIT_REGIST,	// Waiting for a +CGREG URC. AT+CGREG? again after REGISTRATION_FALLBACK_INTERVAL.
+		ASYNC_STATE_ACTIVATE_CGREG,			// AT+CGREG? sent.
+		ASYNC_STATE_ACTIVATE_WAIT_QIACT,	// Waiting POLLING_INTERVAL before retrying AT+QIACT.
+		ASYNC_STATE_ACTIVATE_QIACT,			// AT+QIACT=1 sent.
+		ASYNC_STATE_ACTIVATE_QIGETERROR,	// AT+QIGETERROR sent after AT+QIACT failed.
+		ASYNC_STATE_SOCKET_OPEN_OK,			// AT+QIOPEN sent.
+		ASYNC_STATE_SOCKET_OPEN_URC,		// Waiting for +QIOPEN.
+		ASYNC_STATE_HTTP_GET_OK,			// AT+QHTTPGET sent.
+		ASYNC_STATE_HTTP_GET_URC,			// Waiting for +QHTTPGET.
+		ASYNC_STATE_HTTP_GET_CONNECT,		// AT+QHTTPREAD sent.
+		ASYNC_STATE_HTTP_GET_READ,			// Reading the body as it arrives.
+		ASYNC_STATE_HTTP_GET_READ_END,		// Waiting for +QHTTPREAD.
+	};
+
+	struct AsyncOperation {
+		AsyncStateType State;
+		AsyncStatus Status;
+		int Result;
+		AsyncCallback Callback;
+		Stopwatch OperationStopwatch;
+		unsigned long OperationTimeout;
+		Stopwatch StepStopwatch;
+		unsigned long StepTimeout;
+		int RegistStatus;
+		int ActivateError;		// <err> of the last +QIGETERROR.
+		int ConnectId;
+		char* Data;
+		int DataSize;
+		long ContentLength;		// -1 until the body ends if +QHTTPGET did not report it.
+		long ReadLength;		// Bytes of the body read so far. Only the first DataSize - 1 are kept.
+		int TerminatorMatch;	// Bytes of "\r\nOK\r\n" matched when ContentLength is -1.
+	};
+	AsyncOperation _Async;
+
+	unsigned long _PhaseOrigin;			// millis() of PhaseTimes 0.
+	bool _PhaseOriginSet;
+	PhaseTimes _PhaseTimes;
+
+	bool _SimReady;						// +CPIN: READY was received.
+
+	long _BaudRate;						// Current rate of the module UART.
+	long _BaudRateRequest;				// Rate to negotiate in TurnOnOrReset.
+	bool _BaudRateFailed;				// _BaudRateRequest failed the probe. Not tried again until SetBaudRate.
+	RegistrationStatus _CSRegistration;
+	RegistrationStatus _PSRegistration;
+
+	// Shadow of the HTTP/SSL configuration on the module. Cleared when the module restarts.
+	bool _HttpSslConfigured;			// sslctxid, sslversion, ciphersuite and seclevel are set.
+	int _HttpRequestHeader;				// requestheader value, or -1 if unknown.
 
 private:
 	bool ReturnOk(bool value)
@@ -43,23 +176,66 @@ private:
 	int ReturnError(int lineNumber, int value, ErrorCodeType errorCode);
 
 	bool IsBusy() const;
-	bool IsRespond();
+	bool WaitForBoot(long timeout);
+	bool WaitForSimReady(long timeout);
+	bool ProbeBaudRate();
+	bool ChangeBaudRate(long baudRate);
 	bool Reset();
 	bool TurnOn();
 
+	void PhaseClear();
+	void PhaseMark(long* phase);
+
+	void ClearRegistration();
+	bool QueryRegistration(bool ps);
+	bool WaitForRegistration(bool ps, long timeout);
+
+	void HttpClearConfig();
+	bool HttpConfig(bool ssl, int requestHeader);
 	bool HttpSetUrl(const char* url);
+	bool HttpPostInternal(const char* url, const byte* data, DataProducer producer, void* context, int dataSize, const char* contentType, const char* headers, int* responseCode);
+	bool HttpGetRequest(const char* url);
+	bool HttpGetSend(int* contentLength);
+	int HttpGetRead(int contentLength, char* data, int dataSize);
+
+	int SocketOpenRequest(const char* host, int port, SocketType type);
+	void SocketOpened(int connectId);
+
+	bool AsyncBegin(AsyncCallback callback, AsyncStateType state, unsigned long operationTimeout, unsigned long stepTimeout);
+	void AsyncSetState(AsyncStateType state, unsigned long stepTimeout);
+	void AsyncWriteCommand(const char* command, AsyncStateType state, unsigned long stepTimeout);
+	void AsyncComplete(AsyncStatus status, int result);
+	void AsyncOnResponse(const char* response);
+	void AsyncActivateQIACT();
+	void AsyncOnRegistration();
+	bool AsyncHttpGetRead();
+	void AsyncOnStepTimeout();
+
+	void OnSocketEvent(int connectId, SocketEventType event);
+
+	bool SyncConnectIdUsed();
+	bool SocketGetUnackedSize(int connectId, int* unackedSize);
+	bool WaitForSendWindow(int connectId, int segmentSize, int* unackedSize, SocketSendStatistics* statistics);
+	int SocketSendStreamInternal(int connectId, const byte* data, int dataSize, DataProducer producer, void* context, SocketSendStatistics* statistics);
 
 public:
 	bool ReadResponseCallback(const char* response);	// Internal use only.
 
 public:
-	Wio3G();
+	Wio3G();	// Defined in Wio3GHardware.cpp.
+	Wio3G(SerialAPI* serial);
 	ErrorCodeType GetLastError() const;
+	void SetReadBufferSize(int size);
+	void GetReceiveStatistics(SerialAPI::ReceiveStatistics* statistics) const;
+	void SetIdleHook(IdleHook hook, void* context = NULL);
+	void GetWaitStatistics(AtSerial::WaitStatistics* command, AtSerial::WaitStatistics* total) const;
 	void Init();
 	void PowerSupplyCellular(bool on);
 	void PowerSupplyLed(bool on);
 	void PowerSupplyGrove(bool on);
 	void LedSetRGB(uint8_t red, uint8_t green, uint8_t blue);
+	bool SetBaudRate(long baudRate);
+	long GetBaudRate() const;
 	bool TurnOnOrReset();
 	bool TurnOff();
 	//bool Sleep();
@@ -69,10 +245,14 @@ public:
 	int GetIMSI(char* imsi, int imsiSize);
 	int GetPhoneNumber(char* number, int numberSize);
 	int GetReceivedSignalStrength();
+	bool Query(int queryMask, QueryResult* result);
 	bool GetTime(struct tm* tim);
 
 	bool WaitForCSRegistration(long timeout = 120000);
 	bool WaitForPSRegistration(long timeout = 120000);
+	void GetCSRegistration(RegistrationStatus* status) const;
+	void GetPSRegistration(RegistrationStatus* status) const;
+	void GetPhaseTimes(PhaseTimes* times) const;
 	bool Activate(const char* accessPointName, const char* userName, const char* password, long waitForRegistTimeout = 120000);
 	bool Deactivate();
 
@@ -81,15 +261,37 @@ public:
 	int SocketOpen(const char* host, int port, SocketType type);
 	bool SocketSend(int connectId, const byte* data, int dataSize);
 	bool SocketSend(int connectId, const char* data);
+	int SocketSendStream(int connectId, const byte* data, int dataSize, SocketSendStatistics* statistics = NULL);
+	int SocketSendStream(int connectId, DataProducer producer, void* context, SocketSendStatistics* statistics = NULL);
 	int SocketReceive(int connectId, byte* data, int dataSize);
 	int SocketReceive(int connectId, char* data, int dataSize);
 	int SocketReceive(int connectId, byte* data, int dataSize, long timeout);
 	int SocketReceive(int connectId, char* data, int dataSize, long timeout);
 	bool SocketClose(int connectId);
+	bool SocketReadable(int connectId) const;
+	bool SocketClosed(int connectId) const;
+	void SetSocketEventCallback(SocketEventCallback callback);
+
+	void Poll();
+
+	bool ActivateAsync(const char* accessPointName, const char* userName, const char* password, AsyncCallback callback = NULL, long waitForRegistTimeout = 120000);
+	bool SocketOpenAsync(const char* host, int port, SocketType type, AsyncCallback callback = NULL);
+	bool HttpGetAsync(const char* url, char* data, int dataSize, AsyncCallback callback = NULL);
+	AsyncStatus GetAsyncStatus() const;
+	int GetAsyncResult() const;
 
 	int HttpGet(const char* url, char* data, int dataSize);
+	int HttpGet(const char* url, DataConsumer consumer, void* context);
 	bool HttpPost(const char* url, const char* data, int* responseCode);
+	bool HttpPost(const char* url, const byte* data, int dataSize, int* responseCode, const char* contentType = NULL, const char* headers = NULL);
+	bool HttpPost(const char* url, DataProducer producer, void* context, int dataSize, int* responseCode, const char* contentType = NULL, const char* headers = NULL);
 
 	bool SendUSSD(const char* in, char* out, int outSize);
 
+#ifdef WIO_AT_STATISTICS
+	int GetAtStatisticsSize() const;
+	const AtStatistics::Entry* GetAtStatistics(int index) const;
+	void ClearAtStatistics();
+#endif // WIO_AT_STATISTICS
+
 };
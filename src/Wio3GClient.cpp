@@ -1,7 +1,14 @@
 #include "Wio3GConfig.h"
 #include "Wio3GClient.h"
 
+#include <string.h>
+
 #define RECEIVE_MAX_LENGTH	(1500)
+#define SEND_MAX_LENGTH		(1460)
+
+#define SEND_IDLE_TIMEOUT	(20)
+
+#define URC_FALLBACK_INTERVAL	(1000)
 
 #define CONNECT_SUCCESS				(1)
 #define CONNECT_TIMED_OUT			(-1)
@@ -14,11 +21,19 @@ Wio3GClient::Wio3GClient(Wio3G* wio)
 	_Wio = wio;
 	_ConnectId = -1;
 	_ReceiveBuffer = new byte[RECEIVE_MAX_LENGTH];
+	_ReceiveHead = 0;
+	_ReceiveSize = 0;
+	_SendBuffer = new byte[SEND_MAX_LENGTH];
+	_SendSize = 0;
+	_SendIdleTimeout = SEND_IDLE_TIMEOUT;
+	_SentBytes = 0;
+	_SendCount = 0;
 }
 
 Wio3GClient::~Wio3GClient()
 {
 	delete [] _ReceiveBuffer;
+	delete [] _SendBuffer;
 }
 
 int Wio3GClient::connect(IPAddress ip, uint16_t port)
@@ -35,6 +50,9 @@ int Wio3GClient::connect(IPAddress ip, uint16_t port)
 	int connectId = _Wio->SocketOpen(ipStr.c_str(), port, Wio3G::SOCKET_TCP);
 	if (connectId < 0) return CONNECT_INVALID_SERVER;
 	_ConnectId = connectId;
+	_ReceiveFallbackStopwatch.Restart();
+	_SentBytes = 0;
+	_SendCount = 0;
 
 	return CONNECT_SUCCESS;
 }
@@ -46,47 +64,124 @@ int Wio3GClient::connect(const char* host, uint16_t port)
 	int connectId = _Wio->SocketOpen(host, port, Wio3G::SOCKET_TCP);
 	if (connectId < 0) return CONNECT_INVALID_SERVER;
 	_ConnectId = connectId;
+	_ReceiveFallbackStopwatch.Restart();
+	_SentBytes = 0;
+	_SendCount = 0;
 
 	return CONNECT_SUCCESS;
 }
 
-size_t Wio3GClient::write(uint8_t data)
+void Wio3GClient::Close()
 {
-	if (!connected()) return 0;
+	if (_ConnectId < 0) return;
+
+	_Wio->SocketClose(_ConnectId);
+	_ConnectId = -1;
+	_ReceiveHead = 0;
+	_ReceiveSize = 0;
+	_SendSize = 0;
+}
 
-	if (!_Wio->SocketSend(_ConnectId, &data, 1)) return 0;
+// write() has already returned success for the buffered bytes, so a failed send closes the connection
+// and connected() returns false, instead of the bytes being dropped unnoticed.
+bool Wio3GClient::SendBuffer()
+{
+	if (_SendSize <= 0) return true;
 
-	return 1;
+	bool result = _Wio->SocketSend(_ConnectId, _SendBuffer, _SendSize);
+	_SendCount++;
+	if (!result) {
+		Close();
+		return false;
+	}
+	_SentBytes += _SendSize;
+	_SendSize = 0;
+
+	return true;
 }
 
+bool Wio3GClient::SendBufferIfIdle()
+{
+	if (_SendSize <= 0) return true;
+	if (_SendIdleStopwatch.ElapsedMilliseconds() < _SendIdleTimeout) return true;
+
+	return SendBuffer();
+}
+
+size_t Wio3GClient::write(uint8_t data)
+{
+	return write(&data, 1);
+}
+
+// Data is coalesced into one AT+QISEND until the buffer is full, flush() is called,
+// or nothing has been written for the idle timeout.
 size_t Wio3GClient::write(const uint8_t* buf, size_t size)
 {
 	if (!connected()) return 0;
 
-	if (!_Wio->SocketSend(_ConnectId, buf, size)) return 0;
+	if (!SendBufferIfIdle()) return 0;
+
+	size_t writtenSize = 0;
+	while (writtenSize < size) {
+		int copySize = SEND_MAX_LENGTH - _SendSize;
+		if (copySize > (int)(size - writtenSize)) copySize = size - writtenSize;
+		memcpy(&_SendBuffer[_SendSize], &buf[writtenSize], copySize);
+		_SendSize += copySize;
+		writtenSize += copySize;
+
+		if (_SendSize >= SEND_MAX_LENGTH) {
+			if (!SendBuffer()) return 0;
+		}
+	}
+	_SendIdleStopwatch.Restart();
+
+	if (_SendIdleTimeout == 0) {
+		if (!SendBuffer()) return 0;
+	}
 
 	return size;
 }
 
+// Buffered bytes are consumed from _ReceiveHead. The buffer is refilled only after it has been drained,
+// so one AT+QIRD fills it from the beginning and no wraparound is needed.
+// AT+QIRD follows the "recv" URC, and is also issued at a slow interval in case a URC was missed, as Wio3G::SocketReceive does.
+int Wio3GClient::FillReceiveBuffer()
+{
+	if (_ReceiveSize > 0) return _ReceiveSize;
+
+	_Wio->Poll();
+	if (!_Wio->SocketReadable(_ConnectId) && _ReceiveFallbackStopwatch.ElapsedMilliseconds() < URC_FALLBACK_INTERVAL) return 0;
+	_ReceiveFallbackStopwatch.Restart();
+
+	int receiveSize = _Wio->SocketReceive(_ConnectId, _ReceiveBuffer, RECEIVE_MAX_LENGTH);
+	if (receiveSize <= 0) return 0;
+
+	_ReceiveHead = 0;
+	_ReceiveSize = receiveSize;
+
+	return _ReceiveSize;
+}
+
 int Wio3GClient::available()
 {
 	if (!connected()) return 0;
 
-	int receiveSize = _Wio->SocketReceive(_ConnectId, _ReceiveBuffer, RECEIVE_MAX_LENGTH);
-	for (int i = 0; i < receiveSize; i++) _ReceiveQueue.push(_ReceiveBuffer[i]);
+	SendBufferIfIdle();
 
-	return _ReceiveQueue.size();
+	return FillReceiveBuffer();
 }
 
 int Wio3GClient::read()
 {
 	if (!connected()) return -1;
 
-	int actualSize = available();
-	if (actualSize <= 0) return -1;	// None is available.
+	SendBufferIfIdle();
 
-	byte data = _ReceiveQueue.front();
-	_ReceiveQueue.pop();
+	if (FillReceiveBuffer() <= 0) return -1;	// None is available.
+
+	byte data = _ReceiveBuffer[_ReceiveHead];
+	_ReceiveHead++;
+	_ReceiveSize--;
 
 	return data;
 }
@@ -95,14 +190,15 @@ int Wio3GClient::read(uint8_t* buf, size_t size)
 {
 	if (!connected()) return 0;
 
-	int actualSize = available();
+	SendBufferIfIdle();
+
+	int actualSize = FillReceiveBuffer();
 	if (actualSize <= 0) return 0;	// None is available.
 
 	int popSize = actualSize <= (int)size ? actualSize : size;
-	for (int i = 0; i < popSize; i++) {
-		buf[i] = _ReceiveQueue.front();
-		_ReceiveQueue.pop();
-	}
+	memcpy(buf, &_ReceiveBuffer[_ReceiveHead], popSize);
+	_ReceiveHead += popSize;
+	_ReceiveSize -= popSize;
 
 	return popSize;
 }
@@ -111,28 +207,35 @@ int Wio3GClient::peek()
 {
 	if (!connected()) return 0;
 
-	int actualSize = available();
-	if (actualSize <= 0) return -1;	// None is available.
+	SendBufferIfIdle();
 
-	return _ReceiveQueue.front();
+	if (FillReceiveBuffer() <= 0) return -1;	// None is available.
+
+	return _ReceiveBuffer[_ReceiveHead];
 }
 
 void Wio3GClient::flush()
 {
-	// Nothing to do.
+	if (!connected()) return;
+
+	SendBuffer();
 }
 
 void Wio3GClient::stop()
 {
 	if (!connected()) return;
 
-	_Wio->SocketClose(_ConnectId);
-	_ConnectId = -1;
-	while (!_ReceiveQueue.empty()) _ReceiveQueue.pop();
+	SendBuffer();
+	Close();
 }
 
+// PubSubClient::loop() calls this on every pass, so it also sends data that has been idle for the timeout.
 uint8_t Wio3GClient::connected()
 {
+	if (_ConnectId < 0) return false;
+
+	SendBufferIfIdle();
+
 	return _ConnectId >= 0 ? true : false;
 }
 
@@ -140,3 +243,26 @@ Wio3GClient::operator bool()
 {
 	return _ConnectId >= 0 ? true : false;
 }
+
+//! Set how long written data may wait for more data before it is sent.
+/*!
+  The timeout is checked when the client is called: connected(), available(), read(), peek() or write().
+  Call flush() when nothing else will call the client.
+  \param timeout milliseconds. 0 sends at the end of every write().
+*/
+void Wio3GClient::SetSendIdleTimeout(unsigned long timeout)
+{
+	_SendIdleTimeout = timeout;
+}
+
+//! Get the number of bytes sent on the current connection.
+unsigned long Wio3GClient::GetSentBytes() const
+{
+	return _SentBytes;
+}
+
+//! Get the number of AT+QISEND issued on the current connection.
+unsigned long Wio3GClient::GetSendCount() const
+{
+	return _SendCount;
+}
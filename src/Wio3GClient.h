@@ -4,15 +4,31 @@
 
 #include "Wio3G.h"
 #include "Client.h"
-#include <queue>
 
+// Client over a TCP socket of Wio3G. Written data is coalesced into one AT+QISEND until the buffer is full,
+// flush() is called, or nothing has been written for the send idle timeout.
+// The timeout is checked on every call, so available(), read(), peek() and connected() may send the buffered data too.
+// A failed send closes the connection: connected() returns false and the buffered data is lost.
 class Wio3GClient : public Client {
 
 protected:
 	Wio3G* _Wio;
 	int _ConnectId;
-	std::queue<byte> _ReceiveQueue;
 	byte* _ReceiveBuffer;
+	int _ReceiveHead;
+	int _ReceiveSize;
+	Stopwatch _ReceiveFallbackStopwatch;	// Since the last AT+QIRD.
+	byte* _SendBuffer;
+	int _SendSize;
+	unsigned long _SendIdleTimeout;
+	Stopwatch _SendIdleStopwatch;
+	unsigned long _SentBytes;
+	unsigned long _SendCount;
+
+	void Close();
+	int FillReceiveBuffer();
+	bool SendBuffer();
+	bool SendBufferIfIdle();
 
 public:
 	Wio3GClient(Wio3G* wio);
@@ -31,4 +47,8 @@ public:
 	virtual uint8_t connected();
 	virtual operator bool();
 
+	void SetSendIdleTimeout(unsigned long timeout);
+	unsigned long GetSentBytes() const;
+	unsigned long GetSendCount() const;
+
 };
@@ -3,3 +3,4 @@
 #include <Arduino.h>
 
 //#define WIO_DEBUG
+//#define WIO_AT_STATISTICS
@@ -1,8 +1,48 @@
 #include "Wio3GConfig.h"
 #include "Wio3GHardware.h"
+#include "Wio3G.h"
+#include "Wio3GRecordQueue.h"
+#include "Internal/HardwareSerialAPI.h"
+
+#include <stm32f4xx_hal.h>
+
+#define BACKUP_SRAM_SIZE	(4096)
 
 HardwareSerial SerialUSB(DEBUG_UART_CORE, DEBUG_UART_TX_PIN, DEBUG_UART_RX_PIN);
 HardwareSerial SerialModule(MODULE_UART_CORE, MODULE_UART_TX_PIN, MODULE_UART_RX_PIN, MODULE_CTS_PIN, MODULE_RTS_PIN);
 
 HardwareSerial SerialUART(GROVE_UART_CORE, GROVE_UART_TX_PIN, GROVE_UART_RX_PIN);
 TwoWire WireI2C(GROVE_I2C_CORE, GROVE_I2C_SCL_PIN, GROVE_I2C_SDA_PIN);
+
+static HardwareSerialAPI SerialModuleAPI(&SerialModule);
+
+// Idle hook of Wio3G(). Sleep until the next interrupt: a received byte or the 1 ms SysTick.
+void Wio3GWaitForInterrupt(void*)
+{
+	__WFI();
+}
+
+//! Use SerialModule of the board.
+Wio3G::Wio3G() : Wio3G(&SerialModuleAPI)
+{
+	SetIdleHook(Wio3GWaitForInterrupt);
+}
+
+//! Enable the 4 KB backup SRAM and return its address.
+/*!
+  The contents are kept across resets and, with VBAT supplied, across power-off.
+  Pass the returned address to Begin() as storage.
+  \param size receives the size of the backup SRAM in bytes.
+*/
+void* Wio3GRecordQueue::BackupSramBegin(int* size)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	PWR->CR |= PWR_CR_DBP;					// Allow writes to the backup domain.
+	RCC->AHB1ENR |= RCC_AHB1ENR_BKPSRAMEN;
+	PWR->CSR |= PWR_CSR_BRE;				// Keep the backup SRAM in standby and VBAT mode.
+	while (!(PWR->CSR & PWR_CSR_BRR)) ;
+
+	*size = BACKUP_SRAM_SIZE;
+
+	return (void*)BKPSRAM_BASE;
+}
@@ -51,3 +51,5 @@ extern HardwareSerial SerialUSB;
 extern HardwareSerial SerialModule;
 extern HardwareSerial SerialUART;
 extern TwoWire WireI2C;
+
+void Wio3GWaitForInterrupt(void* context);
@@ -0,0 +1,466 @@
+#include "Wio3GConfig.h"
+#include "Wio3GHttpClient.h"
+
+#include "Internal/Debug.h"
+#include <string.h>
+#include <stdlib.h>
+
+#define HOST_MAX_LENGTH		(64)
+#define LINE_MAX_LENGTH		(128)	// Longer header lines are truncated. The fields parsed here fit.
+#define PIPELINE_MAX		(8)
+
+#define RECEIVE_MAX_LENGTH	(1500)
+#define SEND_MAX_LENGTH		(1460)
+
+Wio3GHttpClient::Wio3GHttpClient(Wio3G* wio)
+{
+	_Wio = wio;
+	_Host = new char[HOST_MAX_LENGTH + 1];
+	_Host[0] = '\0';
+	_Port = 80;
+	_ConnectId = -1;
+	_PendingNum = 0;
+	_Reused = false;
+	_ClosedBeforeResponse = false;
+	_PendingHead = 0;
+	_SendBuffer = new byte[SEND_MAX_LENGTH];
+	_SendSize = 0;
+	_ReceiveBuffer = new byte[RECEIVE_MAX_LENGTH];
+	_ReceiveHead = 0;
+	_ReceiveSize = 0;
+	_Line = new char[LINE_MAX_LENGTH + 1];
+	_LineLength = 0;
+	_LineDone = false;
+	_ParserState = PARSER_DONE;
+	_BodyRemain = 0;
+	_ConnectCount = 0;
+	_RequestCount = 0;
+}
+
+Wio3GHttpClient::~Wio3GHttpClient()
+{
+	Close();
+
+	delete [] _Host;
+	delete [] _SendBuffer;
+	delete [] _ReceiveBuffer;
+	delete [] _Line;
+}
+
+bool Wio3GHttpClient::Connect()
+{
+	if (_ConnectId >= 0) return true;
+
+	int connectId = _Wio->SocketOpen(_Host, _Port, Wio3G::SOCKET_TCP);
+	if (connectId < 0) return false;
+	_ConnectId = connectId;
+	_SendSize = 0;
+	_ReceiveHead = 0;
+	_ReceiveSize = 0;
+	_ConnectCount++;
+
+	return true;
+}
+
+bool Wio3GHttpClient::Write(const char* str)
+{
+	return Write((const byte*)str, strlen(str));
+}
+
+// Requests are assembled in the send buffer and sent in segments of up to SEND_MAX_LENGTH bytes.
+bool Wio3GHttpClient::Write(const byte* data, int dataSize)
+{
+	while (dataSize > 0) {
+		int copySize = SEND_MAX_LENGTH - _SendSize;
+		if (copySize > dataSize) copySize = dataSize;
+		memcpy(&_SendBuffer[_SendSize], data, copySize);
+		_SendSize += copySize;
+		data += copySize;
+		dataSize -= copySize;
+
+		if (_SendSize >= SEND_MAX_LENGTH) {
+			if (!Flush()) return false;
+		}
+	}
+
+	return true;
+}
+
+bool Wio3GHttpClient::Flush()
+{
+	if (_SendSize <= 0) return true;
+
+	bool result = _Wio->SocketSend(_ConnectId, _SendBuffer, _SendSize);
+	_SendSize = 0;
+
+	return result;
+}
+
+// Read a line from the receive buffer. Returns false if the buffer ran out before LF.
+bool Wio3GHttpClient::ReadLine()
+{
+	if (_LineDone) {
+		_LineLength = 0;
+		_LineDone = false;
+	}
+
+	while (_ReceiveSize > 0) {
+		char c = _ReceiveBuffer[_ReceiveHead];
+		_ReceiveHead++;
+		_ReceiveSize--;
+
+		if (c == '\n') {
+			_Line[_LineLength] = '\0';
+			_LineDone = true;
+			return true;
+		}
+		if (c != '\r' && _LineLength < LINE_MAX_LENGTH) _Line[_LineLength++] = c;
+	}
+
+	return false;
+}
+
+void Wio3GHttpClient::ParseHeader(Response* response)
+{
+	const char* value = strchr(_Line, ':');
+	if (value == NULL) return;
+	int nameLength = value - _Line;
+	value++;
+	while (*value == ' ' || *value == '\t') value++;
+
+	if (nameLength == 14 && strncasecmp(_Line, "Content-Length", 14) == 0) {
+		response->ContentLength = atol(value);
+	}
+	else if (nameLength == 17 && strncasecmp(_Line, "Transfer-Encoding", 17) == 0) {
+		if (strstr(value, "chunked") != NULL) response->Chunked = true;
+	}
+	else if (nameLength == 10 && strncasecmp(_Line, "Connection", 10) == 0) {
+		if (strncasecmp(value, "close", 5) == 0) response->KeepAlive = false;
+		else if (strncasecmp(value, "keep-alive", 10) == 0) response->KeepAlive = true;
+	}
+}
+
+void Wio3GHttpClient::BeginBody(bool head, Response* response)
+{
+	if (100 <= response->StatusCode && response->StatusCode <= 199) {
+		_ParserState = PARSER_STATUS_LINE;	// Interim response. The final one follows.
+	}
+	else if (head || response->StatusCode == 204 || response->StatusCode == 304) {
+		_ParserState = PARSER_DONE;
+	}
+	else if (response->Chunked) {
+		response->ContentLength = -1;
+		_ParserState = PARSER_CHUNK_SIZE;
+	}
+	else if (response->ContentLength >= 0) {
+		_BodyRemain = response->ContentLength;
+		_ParserState = _BodyRemain > 0 ? PARSER_BODY : PARSER_DONE;
+	}
+	else {
+		response->KeepAlive = false;
+		_ParserState = PARSER_BODY_UNTIL_CLOSE;
+	}
+}
+
+// Pass size bytes of the receive buffer to the consumer without copying.
+bool Wio3GHttpClient::ConsumeBody(int size, Response* response, BodyConsumer consumer, void* context)
+{
+	const byte* data = &_ReceiveBuffer[_ReceiveHead];
+	_ReceiveHead += size;
+	_ReceiveSize -= size;
+	response->BodyLength += size;
+
+	if (consumer == NULL) return true;
+
+	return consumer(data, size, context);
+}
+
+bool Wio3GHttpClient::WriteRequest(const char* method, const char* path, const byte* body, int bodySize, const char* contentType, const char* headers)
+{
+	char str[30];
+	if (!Write(method)) return false;
+	if (!Write(" ")) return false;
+	if (!Write(path)) return false;
+	if (!Write(" HTTP/1.1\r\nHost: ")) return false;
+	if (!Write(_Host)) return false;
+	if (_Port != 80) {
+		sprintf(str, ":%d", _Port);
+		if (!Write(str)) return false;
+	}
+	if (!Write("\r\n")) return false;
+	if (headers != NULL) {
+		if (!Write(headers)) return false;
+	}
+	if (body != NULL) {
+		if (contentType != NULL) {
+			if (!Write("Content-Type: ")) return false;
+			if (!Write(contentType)) return false;
+			if (!Write("\r\n")) return false;
+		}
+		sprintf(str, "Content-Length: %d\r\n", bodySize);
+		if (!Write(str)) return false;
+	}
+	if (!Write("\r\n")) return false;
+	if (body != NULL) {
+		if (!Write(body, bodySize)) return false;
+	}
+	if (!Flush()) return false;
+
+	return true;
+}
+
+// Receive and parse one response. *closed is set if the server closed the connection.
+bool Wio3GHttpClient::ParseResponse(Response* response, BodyConsumer consumer, void* context, long timeout, bool* closed)
+{
+	bool head = _PendingHead & 1 ? true : false;
+	_ParserState = PARSER_STATUS_LINE;
+	_LineLength = 0;
+	_LineDone = false;
+	*closed = false;
+
+	Stopwatch sw;
+	sw.Restart();
+	while (_ParserState != PARSER_DONE) {
+		if (_ReceiveSize <= 0) {
+			if (*closed) {
+				if (_ParserState == PARSER_BODY_UNTIL_CLOSE) return true;
+				return false;
+			}
+
+			long remain = timeout - (long)sw.ElapsedMilliseconds();
+			if (remain <= 0) return false;
+			int receiveSize = _Wio->SocketReceive(_ConnectId, _ReceiveBuffer, RECEIVE_MAX_LENGTH, remain);
+			if (receiveSize < 0) return false;
+			if (receiveSize == 0) {
+				if (_Wio->SocketClosed(_ConnectId)) *closed = true;
+				continue;
+			}
+			_ReceiveHead = 0;
+			_ReceiveSize = receiveSize;
+		}
+
+		int size;
+		switch (_ParserState) {
+		case PARSER_STATUS_LINE:
+			if (!ReadLine()) break;
+			if (strncmp(_Line, "HTTP/1.", 7) != 0 || _LineLength < 12) {
+				_ParserState = PARSER_FAILED;
+				break;
+			}
+			response->StatusCode = atoi(&_Line[9]);
+			response->ContentLength = -1;
+			response->Chunked = false;
+			response->KeepAlive = _Line[7] == '1';	// HTTP/1.0 closes unless told otherwise.
+			_ParserState = PARSER_HEADER;
+			break;
+
+		case PARSER_HEADER:
+			if (!ReadLine()) break;
+			if (_LineLength <= 0) {
+				BeginBody(head, response);
+			}
+			else {
+				ParseHeader(response);
+			}
+			break;
+
+		case PARSER_BODY:
+		case PARSER_CHUNK_DATA:
+			size = _BodyRemain < _ReceiveSize ? _BodyRemain : _ReceiveSize;
+			if (!ConsumeBody(size, response, consumer, context)) return false;
+			_BodyRemain -= size;
+			if (_BodyRemain <= 0) _ParserState = _ParserState == PARSER_BODY ? PARSER_DONE : PARSER_CHUNK_END;
+			break;
+
+		case PARSER_BODY_UNTIL_CLOSE:
+			if (!ConsumeBody(_ReceiveSize, response, consumer, context)) return false;
+			break;
+
+		case PARSER_CHUNK_SIZE:
+			if (!ReadLine()) break;
+			_BodyRemain = strtol(_Line, NULL, 16);
+			if (_BodyRemain < 0) {
+				_ParserState = PARSER_FAILED;
+				break;
+			}
+			_ParserState = _BodyRemain > 0 ? PARSER_CHUNK_DATA : PARSER_CHUNK_TRAILER;
+			break;
+
+		case PARSER_CHUNK_END:
+			if (!ReadLine()) break;
+			_ParserState = PARSER_CHUNK_SIZE;
+			break;
+
+		case PARSER_CHUNK_TRAILER:
+			if (!ReadLine()) break;
+			if (_LineLength <= 0) _ParserState = PARSER_DONE;
+			break;
+
+		default:
+			break;
+		}
+		if (_ParserState == PARSER_FAILED) return false;
+	}
+
+	return true;
+}
+
+//! Set the host to send requests to. The connection is opened by the first request.
+/*!
+  Changing the host closes the current connection.
+*/
+bool Wio3GHttpClient::SetHost(const char* host, int port)
+{
+	if (host == NULL || strlen(host) > HOST_MAX_LENGTH) return false;
+
+	if (strcmp(_Host, host) != 0 || _Port != port) Close();
+	strcpy(_Host, host);
+	_Port = port;
+
+	return true;
+}
+
+//! Send a request without waiting for the response.
+/*!
+  Up to 8 requests can be pending. Read their responses in order with ReadResponse.
+  \param method "GET", "POST", "HEAD" and so on.
+  \param body the request body, or NULL.
+  \param contentType the value of Content-Type. Sent only if body is not NULL.
+  \param headers additional header lines, each terminated by CR LF. Can be NULL.
+*/
+bool Wio3GHttpClient::SendRequest(const char* method, const char* path, const byte* body, int bodySize, const char* contentType, const char* headers)
+{
+	if (_Host[0] == '\0') return false;
+	if (_PendingNum >= PIPELINE_MAX) return false;
+
+	// Reopen only between responses. A request cannot be moved to a new connection once sent.
+	if (_PendingNum <= 0 && _ConnectId >= 0) {
+		_Wio->Poll();	// A "closed" URC may be waiting in the UART.
+		if (_Wio->SocketClosed(_ConnectId)) Close();
+	}
+	if (_ConnectId < 0 && _PendingNum > 0) return false;
+	bool reused = _ConnectId >= 0 && _PendingNum <= 0;
+	if (!Connect()) return false;
+
+	if (!WriteRequest(method, path, body, bodySize, contentType, headers)) {
+		Close();
+		// The server may have just closed the idle connection. Nothing was sent on it that needs an answer, so use a new one.
+		if (!reused) return false;
+		reused = false;
+		if (!Connect()) return false;
+		if (!WriteRequest(method, path, body, bodySize, contentType, headers)) {
+			Close();
+			return false;
+		}
+	}
+
+	if (_PendingNum <= 0) _Reused = reused;
+	if (strcmp(method, "HEAD") == 0) _PendingHead |= 1UL << _PendingNum;
+	_PendingNum++;
+	_RequestCount++;
+
+	return true;
+}
+
+//! Read the response to the oldest pending request.
+/*!
+  The status line and headers are parsed as they arrive, and the body is passed to consumer piece by piece.
+  Content-Length, chunked and until-close bodies are supported.
+  \param response receives the status code and header information.
+  \param consumer a function that receives the body. Can be NULL to discard it.
+  \param timeout the maximum time to wait for the whole response [msec.].
+  \return the status code, or -1 on failure. On failure the connection is closed.
+*/
+int Wio3GHttpClient::ReadResponse(Response* response, BodyConsumer consumer, void* context, long timeout)
+{
+	if (_PendingNum <= 0 || _ConnectId < 0) return -1;
+
+	response->StatusCode = -1;
+	response->ContentLength = -1;
+	response->Chunked = false;
+	response->KeepAlive = true;
+	response->BodyLength = 0;
+
+	bool closed;
+	_ClosedBeforeResponse = false;
+	if (!ParseResponse(response, consumer, context, timeout, &closed)) {
+		DEBUG_PRINTLN("### HTTP RESPONSE ERROR ###");
+		_ClosedBeforeResponse = closed && response->StatusCode < 0;
+		Close();
+		return -1;
+	}
+
+	_PendingNum--;
+	_PendingHead >>= 1;
+	if (!response->KeepAlive || closed) Close();
+
+	return response->StatusCode;
+}
+
+// Send one request and read its response. A request that went on a reused connection which the server closed
+// before answering is sent once more on a new connection, as the server may close an idle connection at any time.
+int Wio3GHttpClient::Request(const char* method, const char* path, const byte* body, int bodySize, const char* contentType, Response* response, BodyConsumer consumer, void* context)
+{
+	if (_PendingNum > 0) return -1;
+
+	if (!SendRequest(method, path, body, bodySize, contentType)) return -1;
+	bool reused = _Reused;
+	int statusCode = ReadResponse(response, consumer, context);
+	if (statusCode >= 0 || !reused || !_ClosedBeforeResponse) return statusCode;
+
+	DEBUG_PRINTLN("### HTTP RETRY ON NEW CONNECTION ###");
+	if (!SendRequest(method, path, body, bodySize, contentType)) return -1;
+
+	return ReadResponse(response, consumer, context);
+}
+
+//! Send a GET request and read the response.
+/*!
+  \return the status code, or -1 on failure. Fails if requests sent with SendRequest are pending.
+*/
+int Wio3GHttpClient::Get(const char* path, Response* response, BodyConsumer consumer, void* context)
+{
+	return Request("GET", path, NULL, 0, NULL, response, consumer, context);
+}
+
+//! Send a POST request and read the response.
+/*!
+  \return the status code, or -1 on failure. Fails if requests sent with SendRequest are pending.
+*/
+int Wio3GHttpClient::Post(const char* path, const byte* body, int bodySize, const char* contentType, Response* response, BodyConsumer consumer, void* context)
+{
+	return Request("POST", path, body, bodySize, contentType, response, consumer, context);
+}
+
+//! Close the connection. Pending requests are discarded.
+void Wio3GHttpClient::Close()
+{
+	if (_ConnectId >= 0) _Wio->SocketClose(_ConnectId);
+	_ConnectId = -1;
+	_PendingNum = 0;
+	_PendingHead = 0;
+	_SendSize = 0;
+	_ReceiveHead = 0;
+	_ReceiveSize = 0;
+}
+
+bool Wio3GHttpClient::IsConnected() const
+{
+	return _ConnectId >= 0 && !_Wio->SocketClosed(_ConnectId);
+}
+
+int Wio3GHttpClient::GetPendingNum() const
+{
+	return _PendingNum;
+}
+
+//! Get the number of TCP connections opened. Compare with GetRequestCount to see how well keep-alive works.
+unsigned long Wio3GHttpClient::GetConnectCount() const
+{
+	return _ConnectCount;
+}
+
+unsigned long Wio3GHttpClient::GetRequestCount() const
+{
+	return _RequestCount;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Wio3GConfig.h"
+
+#include "Wio3G.h"
+
+// HTTP/1.1 client on a TCP socket of Wio3G.
+// The connection to the host is kept open across requests and reopened when the server closes it.
+// Get and Post send a request once more on a new connection if the server closed the idle one before answering.
+// Requests can be pipelined: call SendRequest several times, then ReadResponse once per request in the same order.
+// Plain HTTP only. The EC21 has TLS sockets (AT+QSSLOPEN/QSSLSEND/QSSLRECV), but Wio3G does not use them yet, so there is no https.
+class Wio3GHttpClient
+{
+public:
+	// Receive a piece of the response body. Return false to stop; the connection is closed and ReadResponse fails.
+	typedef bool (*BodyConsumer)(const byte* data, int dataSize, void* context);
+
+	struct Response {
+		int StatusCode;
+		long ContentLength;		// -1 if the body is chunked or ends at close.
+		bool Chunked;
+		bool KeepAlive;
+		long BodyLength;		// Bytes passed to the consumer.
+	};
+
+private:
+	enum ParserStateType {
+		PARSER_STATUS_LINE,
+		PARSER_HEADER,
+		PARSER_BODY,
+		PARSER_BODY_UNTIL_CLOSE,
+		PARSER_CHUNK_SIZE,
+		PARSER_CHUNK_DATA,
+		PARSER_CHUNK_END,
+		PARSER_CHUNK_TRAILER,
+		PARSER_DONE,
+		PARSER_FAILED,
+	};
+
+	Wio3G* _Wio;
+	char* _Host;
+	int _Port;
+	int _ConnectId;
+	int _PendingNum;				// Requests sent whose response has not been read.
+	bool _Reused;					// The oldest pending request went on a connection that had already served one.
+	bool _ClosedBeforeResponse;		// The last ReadResponse failed because the server closed before the status line.
+	unsigned long _PendingHead;		// Bit per pending request, oldest in bit 0. Set for HEAD.
+	byte* _SendBuffer;
+	int _SendSize;
+	byte* _ReceiveBuffer;
+	int _ReceiveHead;
+	int _ReceiveSize;
+	char* _Line;
+	int _LineLength;
+	bool _LineDone;
+	ParserStateType _ParserState;
+	long _BodyRemain;
+	unsigned long _ConnectCount;
+	unsigned long _RequestCount;
+
+	bool Connect();
+	bool Write(const char* str);
+	bool Write(const byte* data, int dataSize);
+	bool Flush();
+	bool ReadLine();
+	void ParseHeader(Response* response);
+	void BeginBody(bool head, Response* response);
+	bool ConsumeBody(int size, Response* response, BodyConsumer consumer, void* context);
+	bool WriteRequest(const char* method, const char* path, const byte* body, int bodySize, const char* contentType, const char* headers);
+	bool ParseResponse(Response* response, BodyConsumer consumer, void* context, long timeout, bool* closed);
+	int Request(const char* method, const char* path, const byte* body, int bodySize, const char* contentType, Response* response, BodyConsumer consumer, void* context);
+
+public:
+	Wio3GHttpClient(Wio3G* wio);
+	~Wio3GHttpClient();
+
+	bool SetHost(const char* host, int port = 80);
+	bool SendRequest(const char* method, const char* path, const byte* body = NULL, int bodySize = 0, const char* contentType = NULL, const char* headers = NULL);
+	int ReadResponse(Response* response, BodyConsumer consumer, void* context, long timeout = 60000);
+	int Get(const char* path, Response* response, BodyConsumer consumer, void* context);
+	int Post(const char* path, const byte* body, int bodySize, const char* contentType, Response* response, BodyConsumer consumer, void* context);
+	void Close();
+
+	bool IsConnected() const;
+	int GetPendingNum() const;
+	unsigned long GetConnectCount() const;
+	unsigned long GetRequestCount() const;
+
+};
@@ -0,0 +1,170 @@
+#include "Wio3GConfig.h"
+#include "Wio3GRecordQueue.h"
+
+#include <string.h>
+
+#define QUEUE_MAGIC			(0x57335251)	// "W3RQ"
+
+#define SLOT_SIZE(recordSize)	(((2 + (recordSize)) + 3) & ~3)
+
+Wio3GRecordQueue::Wio3GRecordQueue() : _Header(NULL), _Records(NULL), _DropPolicy(DROP_OLDEST)
+{
+}
+
+int Wio3GRecordQueue::Head() const
+{
+	return _Header->Position & 0xffff;
+}
+
+int Wio3GRecordQueue::Count() const
+{
+	return _Header->Position >> 16;
+}
+
+// Head and Count change together in a single 32-bit store, so a reset sees either the old or the new pair.
+// The store is a release: the record written before it is complete when the new Count is visible.
+void Wio3GRecordQueue::Commit(int head, int count)
+{
+	__atomic_store_n(&_Header->Position, (uint32_t)count << 16 | (uint32_t)head, __ATOMIC_RELEASE);
+}
+
+byte* Wio3GRecordQueue::Slot(int index) const
+{
+	int position = (Head() + index) % _Header->RecordNum;
+
+	return &_Records[position * SLOT_SIZE(_Header->RecordSize)];
+}
+
+//! Attach the queue to storage.
+/*!
+  If the storage already holds a queue with the same record size and capacity, its records and statistics are kept.
+  \param storage a buffer that outlives the queue. It must be 4-byte aligned.
+  \param recordSize the maximum length of one record in bytes.
+  \return false if the storage cannot hold a single record.
+*/
+bool Wio3GRecordQueue::Begin(void* storage, int storageSize, int recordSize, DropPolicyType dropPolicy)
+{
+	if (storage == NULL || ((uintptr_t)storage & 3) != 0) return false;
+	if (recordSize <= 0 || 65535 < recordSize) return false;
+
+	int recordNum = (storageSize - (int)sizeof(Header)) / SLOT_SIZE(recordSize);
+	if (recordNum <= 0) return false;
+	if (recordNum > 65535) recordNum = 65535;
+
+	_Header = (Header*)storage;
+	_Records = (byte*)storage + sizeof(Header);
+	_DropPolicy = dropPolicy;
+
+	if (_Header->Magic != QUEUE_MAGIC || _Header->RecordSize != recordSize || _Header->RecordNum != recordNum ||
+		Head() >= recordNum || Count() > recordNum) {
+		_Header->RecordSize = recordSize;
+		_Header->RecordNum = recordNum;
+		memset(&_Header->Stat, 0, sizeof(_Header->Stat));
+		Clear();
+		_Header->Magic = QUEUE_MAGIC;
+	}
+
+	return true;
+}
+
+//! Discard all records. The statistics are kept.
+void Wio3GRecordQueue::Clear()
+{
+	if (_Header == NULL) return;
+
+	Commit(0, 0);
+}
+
+//! Add a record at the tail.
+/*!
+  \return false if dataSize is larger than the record size, or the queue is full with DROP_NEWEST.
+*/
+bool Wio3GRecordQueue::Push(const byte* data, int dataSize)
+{
+	if (_Header == NULL) return false;
+	if (dataSize < 0 || _Header->RecordSize < dataSize) return false;
+
+	int count = Count();
+	if (count >= _Header->RecordNum) {
+		_Header->Stat.Dropped++;
+		if (_DropPolicy == DROP_NEWEST) return false;
+
+		// The new record goes into the slot of the oldest one, so drop the oldest before writing.
+		Commit((Head() + 1) % _Header->RecordNum, --count);
+	}
+
+	byte* slot = Slot(count);
+	slot[0] = dataSize & 0xff;
+	slot[1] = dataSize >> 8;
+	memcpy(&slot[2], data, dataSize);
+	Commit(Head(), ++count);	// Last, so a reset during Push does not expose a partial record.
+
+	_Header->Stat.Pushed++;
+	if ((unsigned long)count > _Header->Stat.HighWater) _Header->Stat.HighWater = count;
+
+	return true;
+}
+
+//! Get a record without removing it.
+/*!
+  \param index 0 for the oldest record.
+  \param dataSize receives the record length.
+  \return a pointer into the storage, or NULL if index is out of range. Valid until the next Push or Pop.
+*/
+const byte* Wio3GRecordQueue::Peek(int index, int* dataSize) const
+{
+	if (_Header == NULL) return NULL;
+	if (index < 0 || Count() <= index) return NULL;
+
+	const byte* slot = Slot(index);
+	*dataSize = slot[0] | slot[1] << 8;
+
+	return &slot[2];
+}
+
+//! Remove records from the head, typically those of a batch that was sent.
+/*!
+  \return the number of records removed.
+*/
+int Wio3GRecordQueue::Pop(int num)
+{
+	if (_Header == NULL) return 0;
+	if (num <= 0) return 0;
+	int count = Count();
+	if (num > count) num = count;
+
+	Commit((Head() + num) % _Header->RecordNum, count - num);
+	_Header->Stat.Popped += num;
+
+	return num;
+}
+
+int Wio3GRecordQueue::Size() const
+{
+	return _Header != NULL ? Count() : 0;
+}
+
+int Wio3GRecordQueue::Capacity() const
+{
+	return _Header != NULL ? _Header->RecordNum : 0;
+}
+
+bool Wio3GRecordQueue::IsEmpty() const
+{
+	return Size() <= 0;
+}
+
+bool Wio3GRecordQueue::IsFull() const
+{
+	return _Header != NULL && Count() >= _Header->RecordNum;
+}
+
+void Wio3GRecordQueue::GetStatistics(Statistics* statistics) const
+{
+	if (_Header == NULL) {
+		memset(statistics, 0, sizeof(*statistics));
+		return;
+	}
+
+	*statistics = _Header->Stat;
+}
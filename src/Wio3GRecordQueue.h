@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Wio3GConfig.h"
+
+// Store-and-forward queue of fixed-size records in caller-provided storage.
+// Push records while the link is down, then Peek a batch, send it and Pop what was sent.
+// The queue state is kept in the storage itself, so a queue in backup SRAM (see BackupSramBegin) survives a reset.
+class Wio3GRecordQueue
+{
+public:
+	enum DropPolicyType {
+		DROP_OLDEST,	// A push to a full queue overwrites the oldest record.
+		DROP_NEWEST,	// A push to a full queue is rejected.
+	};
+
+	struct Statistics {
+		unsigned long Pushed;
+		unsigned long Popped;
+		unsigned long Dropped;		// Records lost to the drop policy.
+		unsigned long HighWater;	// Largest number of records held.
+	};
+
+private:
+	struct Header {
+		uint32_t Magic;
+		uint16_t RecordSize;
+		uint16_t RecordNum;
+		uint32_t Position;		// Head in the low 16 bits and Count in the high 16 bits, so both change in one store.
+		Statistics Stat;
+	};
+
+	Header* _Header;
+	byte* _Records;				// RecordNum slots of [length (2 bytes)][data (RecordSize bytes)].
+	DropPolicyType _DropPolicy;
+
+	int Head() const;
+	int Count() const;
+	void Commit(int head, int count);
+	byte* Slot(int index) const;
+
+public:
+	static void* BackupSramBegin(int* size);	// In Wio3GHardware.cpp.
+
+	Wio3GRecordQueue();
+
+	bool Begin(void* storage, int storageSize, int recordSize, DropPolicyType dropPolicy = DROP_OLDEST);
+	void Clear();
+
+	bool Push(const byte* data, int dataSize);
+	const byte* Peek(int index, int* dataSize) const;
+	int Pop(int num = 1);
+
+	int Size() const;
+	int Capacity() const;
+	bool IsEmpty() const;
+	bool IsFull() const;
+	void GetStatistics(Statistics* statistics) const;
+
+};
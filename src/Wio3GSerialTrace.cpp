@@ -0,0 +1,169 @@
+#include "Wio3GConfig.h"
+#include "Wio3GSerialTrace.h"
+
+#include <stdio.h>
+
+#define TRACE_HEADER_SIZE		(5)
+#define TRACE_RECORD_MAX_LENGTH	(128)
+#define TRACE_MERGE_INTERVAL	(1000)
+#define TRACE_FROM_MODULE		(0x80)
+
+Wio3GSerialTrace::Wio3GSerialTrace(SerialAPI* serial, byte* buffer, int bufferSize)
+{
+	_Serial = serial;
+	_Buffer = buffer;
+	_BufferSize = bufferSize;
+	_DroppedCount = 0;
+	_Enabled = true;
+	Clear();
+}
+
+byte Wio3GSerialTrace::Get(int index) const
+{
+	return _Buffer[(_Head + index) % _BufferSize];
+}
+
+void Wio3GSerialTrace::Put(byte data)
+{
+	_Buffer[(_Head + _Size) % _BufferSize] = data;
+	_Size++;
+}
+
+void Wio3GSerialTrace::DropOldest()
+{
+	int recordSize = TRACE_HEADER_SIZE + (Get(0) & ~TRACE_FROM_MODULE) + 1;
+	if (_OpenRecord == _Head) _OpenRecord = -1;
+	_Head = (_Head + recordSize) % _BufferSize;
+	_Size -= recordSize;
+	_DroppedCount++;
+}
+
+void Wio3GSerialTrace::Record(bool fromModule, const byte* data, int dataSize)
+{
+	if (!_Enabled || _BufferSize < TRACE_HEADER_SIZE + TRACE_RECORD_MAX_LENGTH) return;
+
+	unsigned long now = micros();
+	for (int i = 0; i < dataSize; i++) {
+		if (_OpenRecord >= 0) {
+			byte header = _Buffer[_OpenRecord];
+			if ((header & TRACE_FROM_MODULE) != (fromModule ? TRACE_FROM_MODULE : 0) || (header & ~TRACE_FROM_MODULE) + 1 >= TRACE_RECORD_MAX_LENGTH || now - _LastTime > TRACE_MERGE_INTERVAL) {
+				_OpenRecord = -1;
+			}
+		}
+
+		if (_OpenRecord < 0) {
+			while (_BufferSize - _Size < TRACE_HEADER_SIZE + 1) DropOldest();
+			_OpenRecord = (_Head + _Size) % _BufferSize;
+			Put(fromModule ? TRACE_FROM_MODULE : 0);
+			for (int j = 0; j < 4; j++) Put((now >> (8 * j)) & 0xff);
+		}
+		else {
+			while (_BufferSize - _Size < 1) DropOldest();	// Never the open record; the buffer holds at least one full record.
+			_Buffer[_OpenRecord]++;
+		}
+		Put(data[i]);
+		_LastTime = now;
+	}
+}
+
+//! Start or stop recording. The transport is passed through either way.
+void Wio3GSerialTrace::SetEnabled(bool enabled)
+{
+	_Enabled = enabled;
+	_OpenRecord = -1;
+}
+
+void Wio3GSerialTrace::Clear()
+{
+	_Head = 0;
+	_Size = 0;
+	_OpenRecord = -1;
+	_LastTime = 0;
+}
+
+//! Print the records oldest first, one per line, as "<micros> <- <hex>" (to the module) or "<micros> -> <hex>" (from the module).
+void Wio3GSerialTrace::Dump(Print& out) const
+{
+	char str[3 + 1];
+
+	for (int index = 0; index < _Size; ) {
+		byte header = Get(index);
+		int length = (header & ~TRACE_FROM_MODULE) + 1;
+		unsigned long time = 0;
+		for (int j = 0; j < 4; j++) time |= (unsigned long)Get(index + 1 + j) << (8 * j);
+
+		out.print(time);
+		out.print(header & TRACE_FROM_MODULE ? " -> " : " <- ");
+		for (int j = 0; j < length; j++) {
+			sprintf(str, "%02X", Get(index + TRACE_HEADER_SIZE + j));
+			out.print(str);
+		}
+		out.println();
+
+		index += TRACE_HEADER_SIZE + length;
+	}
+}
+
+//! Get the number of records dropped because the buffer was full.
+unsigned long Wio3GSerialTrace::GetDroppedCount() const
+{
+	return _DroppedCount;
+}
+
+void Wio3GSerialTrace::Begin(int baud)
+{
+	_Serial->Begin(baud);
+}
+
+void Wio3GSerialTrace::SetWriteTimeout(unsigned long timeout)
+{
+	_Serial->SetWriteTimeout(timeout);
+}
+
+unsigned long Wio3GSerialTrace::GetWriteTimeout() const
+{
+	return _Serial->GetWriteTimeout();
+}
+
+void Wio3GSerialTrace::Write(byte data)
+{
+	Record(false, &data, 1);
+	_Serial->Write(data);
+}
+
+void Wio3GSerialTrace::Write(const byte* data, int dataSize)
+{
+	Record(false, data, dataSize);
+	_Serial->Write(data, dataSize);
+}
+
+bool Wio3GSerialTrace::Available() const
+{
+	return _Serial->Available();
+}
+
+byte Wio3GSerialTrace::Read()
+{
+	byte data = _Serial->Read();
+	Record(true, &data, 1);
+
+	return data;
+}
+
+int Wio3GSerialTrace::Read(byte* data, int dataSize)
+{
+	int size = _Serial->Read(data, dataSize);
+	if (size > 0) Record(true, data, size);
+
+	return size;
+}
+
+void Wio3GSerialTrace::SetReadBufferSize(int size)
+{
+	_Serial->SetReadBufferSize(size);
+}
+
+void Wio3GSerialTrace::GetReceiveStatistics(ReceiveStatistics* statistics) const
+{
+	_Serial->GetReceiveStatistics(statistics);
+}
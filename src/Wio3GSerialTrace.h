@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Wio3GConfig.h"
+
+#include "Wio3G.h"
+
+// Serial transport that records the traffic of another transport into a ring buffer.
+// Pass it to Wio3G(SerialAPI*) and Dump() the trace later, e.g. to SerialUSB. Recording costs no output while running.
+// Each record is [header (1 byte): bit 7 = direction (1 = from the module), bits 0-6 = data length - 1][micros() (4 bytes, little endian)][data].
+// Bytes in the same direction within TRACE_MERGE_INTERVAL microseconds are merged into one record. The oldest records are dropped when full.
+class Wio3GSerialTrace : public SerialAPI
+{
+private:
+	SerialAPI* _Serial;
+	byte* _Buffer;
+	int _BufferSize;
+	int _Head;					// Oldest record.
+	int _Size;
+	int _OpenRecord;			// Index of the header of the record still being extended, or -1.
+	unsigned long _LastTime;	// micros() of the last recorded byte.
+	unsigned long _DroppedCount;
+	bool _Enabled;
+
+	byte Get(int index) const;
+	void Put(byte data);
+	void DropOldest();
+	void Record(bool fromModule, const byte* data, int dataSize);
+
+public:
+	Wio3GSerialTrace(SerialAPI* serial, byte* buffer, int bufferSize);
+
+	void SetEnabled(bool enabled);
+	void Clear();
+	void Dump(Print& out) const;
+	unsigned long GetDroppedCount() const;
+
+	virtual void Begin(int baud);
+	virtual void SetWriteTimeout(unsigned long timeout);
+	virtual unsigned long GetWriteTimeout() const;
+	virtual void Write(byte data);
+	virtual void Write(const byte* data, int dataSize);
+	virtual bool Available() const;
+	virtual byte Read();
+	virtual int Read(byte* data, int dataSize);
+	virtual void SetReadBufferSize(int size);
+	virtual void GetReceiveStatistics(ReceiveStatistics* statistics) const;
+
+};
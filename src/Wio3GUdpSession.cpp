@@ -0,0 +1,225 @@
+#include "Wio3GConfig.h"
+#include "Wio3GUdpSession.h"
+
+#include <string.h>
+
+#define HOST_MAX_LENGTH		(64)
+#define QUEUE_MAX_SIZE		(1500)
+#define DATAGRAM_MAX_LENGTH	(1460)	// AT+QISEND limit.
+#define SEND_TRY_MAX		(3)		// Attempts per datagram on an open socket, one per SendQueue().
+#define RECEIVE_MAX_LENGTH	(1500)
+#define RECEIVE_MAX_NUM		(4)		// Datagrams read per Poll().
+#define REOPEN_INTERVAL		(10000)
+
+Wio3GUdpSession::Wio3GUdpSession(Wio3G* wio)
+{
+	_Wio = wio;
+	_Host = new char[HOST_MAX_LENGTH + 1];
+	_Host[0] = '\0';
+	_Port = 0;
+	_ConnectId = -1;
+	_OpenTried = false;
+	_Queue = new byte[QUEUE_MAX_SIZE];
+	_QueueSize = 0;
+	_QueueNum = 0;
+	_HeadFailNum = 0;
+	_ReceiveBuffer = new byte[RECEIVE_MAX_LENGTH];
+	_ReceiveCallback = NULL;
+	_ReceiveContext = NULL;
+	_OpenCount = 0;
+	_SentCount = 0;
+	_ReceivedCount = 0;
+	_DroppedCount = 0;
+}
+
+Wio3GUdpSession::~Wio3GUdpSession()
+{
+	End();
+
+	delete [] _Host;
+	delete [] _Queue;
+	delete [] _ReceiveBuffer;
+}
+
+bool Wio3GUdpSession::Open()
+{
+	if (_ConnectId >= 0) return true;
+
+	// Do not retry a failed open on every Poll(). AT+QIOPEN fails at once while the PDP context is down.
+	if (_OpenTried && _OpenStopwatch.ElapsedMilliseconds() < REOPEN_INTERVAL) return false;
+	_OpenTried = true;
+	_OpenStopwatch.Restart();
+
+	int connectId = _Wio->SocketOpen(_Host, _Port, Wio3G::SOCKET_UDP);
+	if (connectId < 0) return false;
+	_ConnectId = connectId;
+	_OpenCount++;
+
+	return true;
+}
+
+void Wio3GUdpSession::CloseSocket()
+{
+	if (_ConnectId < 0) return;
+
+	_Wio->SocketClose(_ConnectId);	// Frees the connectId even after "closed".
+	_ConnectId = -1;
+}
+
+void Wio3GUdpSession::DequeueHead()
+{
+	int dataSize = _Queue[0] | _Queue[1] << 8;
+	memmove(&_Queue[0], &_Queue[2 + dataSize], _QueueSize - (2 + dataSize));
+	_QueueSize -= 2 + dataSize;
+	_QueueNum--;
+	_HeadFailNum = 0;
+}
+
+// Send the queued datagrams in order, until one fails. A datagram stays queued if sending it fails because the socket closed.
+// One the module keeps refusing on an open socket is dropped and counted after SEND_TRY_MAX calls, so it does not block the queue.
+// At most one attempt fails per call, so a refused datagram holds up Poll() for one prompt timeout at most.
+bool Wio3GUdpSession::SendQueue()
+{
+	while (_QueueNum > 0) {
+		int dataSize = _Queue[0] | _Queue[1] << 8;
+		if (!_Wio->SocketSend(_ConnectId, &_Queue[2], dataSize)) {
+			if (_Wio->SocketClosed(_ConnectId)) return false;
+			if (++_HeadFailNum >= SEND_TRY_MAX) {
+				_DroppedCount++;
+				DequeueHead();
+			}
+			return false;
+		}
+		_SentCount++;
+		DequeueHead();
+	}
+
+	return true;
+}
+
+void Wio3GUdpSession::ReceiveAll()
+{
+	for (int i = 0; i < RECEIVE_MAX_NUM; i++) {
+		if (!_Wio->SocketReadable(_ConnectId)) break;
+
+		int dataSize = _Wio->SocketReceive(_ConnectId, _ReceiveBuffer, RECEIVE_MAX_LENGTH);
+		if (dataSize <= 0) break;
+		_ReceivedCount++;
+
+		if (_ReceiveCallback != NULL) _ReceiveCallback(_ReceiveBuffer, dataSize, _ReceiveContext);
+	}
+}
+
+//! Set the destination and open the socket.
+/*!
+  \return false if the socket could not be opened now. Poll() retries the open later, so datagrams can still be queued.
+*/
+bool Wio3GUdpSession::Begin(const char* host, int port)
+{
+	if (host == NULL || strlen(host) > HOST_MAX_LENGTH) return false;
+
+	End();
+	strcpy(_Host, host);
+	_Port = port;
+	_OpenTried = false;
+
+	return Open();
+}
+
+//! Close the socket and discard the queued datagrams.
+void Wio3GUdpSession::End()
+{
+	CloseSocket();
+	_Host[0] = '\0';
+	_QueueSize = 0;
+	_QueueNum = 0;
+	_HeadFailNum = 0;
+}
+
+//! Set a function called from Poll() for each received datagram.
+void Wio3GUdpSession::SetReceiveCallback(ReceiveCallback callback, void* context)
+{
+	_ReceiveCallback = callback;
+	_ReceiveContext = context;
+}
+
+//! Queue a datagram and send the queue if the socket is open.
+/*!
+  \param dataSize up to 1460 bytes.
+  \return false if the datagram is too long, or does not fit in the queue. The latter is counted in GetDroppedCount.
+*/
+bool Wio3GUdpSession::Send(const byte* data, int dataSize)
+{
+	if (_Host[0] == '\0') return false;
+	if (dataSize < 0 || DATAGRAM_MAX_LENGTH < dataSize) return false;
+
+	if (_QueueSize + 2 + dataSize > QUEUE_MAX_SIZE) {
+		_DroppedCount++;
+		return false;
+	}
+	_Queue[_QueueSize] = dataSize & 0xff;
+	_Queue[_QueueSize + 1] = dataSize >> 8;
+	memcpy(&_Queue[_QueueSize + 2], data, dataSize);
+	_QueueSize += 2 + dataSize;
+	_QueueNum++;
+
+	if (_ConnectId >= 0) SendQueue();
+
+	return true;
+}
+
+bool Wio3GUdpSession::Send(const char* data)
+{
+	return Send((const byte*)data, strlen(data));
+}
+
+//! Reopen the socket if needed, send the queue and receive datagrams. Call it from loop().
+void Wio3GUdpSession::Poll()
+{
+	if (_Host[0] == '\0') return;
+
+	_Wio->Poll();
+
+	if (_ConnectId >= 0) {
+		ReceiveAll();
+
+		if (_Wio->SocketClosed(_ConnectId)) {
+			CloseSocket();
+			_OpenTried = false;		// Reopen at once.
+		}
+	}
+	if (!Open()) return;
+
+	SendQueue();
+}
+
+bool Wio3GUdpSession::IsOpen() const
+{
+	return _ConnectId >= 0 && !_Wio->SocketClosed(_ConnectId);
+}
+
+int Wio3GUdpSession::GetQueuedNum() const
+{
+	return _QueueNum;
+}
+
+unsigned long Wio3GUdpSession::GetOpenCount() const
+{
+	return _OpenCount;
+}
+
+unsigned long Wio3GUdpSession::GetSentCount() const
+{
+	return _SentCount;
+}
+
+unsigned long Wio3GUdpSession::GetReceivedCount() const
+{
+	return _ReceivedCount;
+}
+
+//! Get the number of datagrams dropped because the queue was full or the module refused them.
+unsigned long Wio3GUdpSession::GetDroppedCount() const
+{
+	return _DroppedCount;
+}
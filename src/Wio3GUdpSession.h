@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Wio3GConfig.h"
+
+#include "Wio3G.h"
+
+// UDP session to one host that stays open across datagrams.
+// Send() queues a datagram and Poll() sends the queue and passes received datagrams to the callback, without waiting.
+// The socket is reopened by Poll() after a "closed" or "pdpdeact" URC. After "pdpdeact", it opens again once the PDP context is activated.
+class Wio3GUdpSession
+{
+public:
+	// Called from Poll() for each received datagram.
+	typedef void (*ReceiveCallback)(const byte* data, int dataSize, void* context);
+
+private:
+	Wio3G* _Wio;
+	char* _Host;
+	int _Port;
+	int _ConnectId;
+	Stopwatch _OpenStopwatch;		// Since the last open attempt.
+	bool _OpenTried;
+	byte* _Queue;					// Datagrams as [length (2 bytes, little endian)][data], oldest first.
+	int _QueueSize;
+	int _QueueNum;
+	int _HeadFailNum;				// Failed attempts to send the oldest datagram.
+	byte* _ReceiveBuffer;
+	ReceiveCallback _ReceiveCallback;
+	void* _ReceiveContext;
+	unsigned long _OpenCount;
+	unsigned long _SentCount;
+	unsigned long _ReceivedCount;
+	unsigned long _DroppedCount;
+
+	bool Open();
+	void CloseSocket();
+	void DequeueHead();
+	bool SendQueue();
+	void ReceiveAll();
+
+public:
+	Wio3GUdpSession(Wio3G* wio);
+	~Wio3GUdpSession();
+
+	bool Begin(const char* host, int port);
+	void End();
+	void SetReceiveCallback(ReceiveCallback callback, void* context);
+
+	bool Send(const byte* data, int dataSize);
+	bool Send(const char* data);
+	void Poll();
+
+	bool IsOpen() const;
+	int GetQueuedNum() const;
+	unsigned long GetOpenCount() const;
+	unsigned long GetSentCount() const;
+	unsigned long GetReceivedCount() const;
+	unsigned long GetDroppedCount() const;
+
+};
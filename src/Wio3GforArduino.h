@@ -2,3 +2,4 @@
 
 #include "Wio3GHardware.h"
 #include "Wio3G.h"
+#include "Internal/HardwareSerialAPI.h"